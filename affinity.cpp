@@ -0,0 +1,276 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <tuple>
+#include <pthread.h>
+#include <sched.h>
+
+// The scheduler may put the threads on any CPU and move them later. Threads
+// that share data work faster on the cores of one socket (they share the last
+// level cache), and independent threads work faster apart (they don't share
+// the cache and the memory bandwidth). Pinning makes the placement explicit.
+
+/** \brief Logical CPU and its place in the machine */
+struct Cpu
+{
+	int id;
+	int core;    // Physical core, hyper-threads share it
+	int package; // Socket
+	int node;    // NUMA node
+};
+
+namespace topology
+{
+	namespace detail
+	{
+		inline int read_int(const std::filesystem::path& path, int fallback)
+		{
+			auto file{ std::ifstream(path) };
+			auto value{ fallback };
+			file >> value;
+			return file ? value : fallback;
+		}
+
+		// Parses the kernel's CPU list format: "0-3,8,10-11"
+		inline std::vector<int> parse_list(const std::string& list)
+		{
+			auto ids{ std::vector<int>{} };
+			auto stream{ std::istringstream(list) };
+			auto range{ std::string{} };
+			while (std::getline(stream, range, ','))
+			{
+				auto dash{ range.find('-') };
+				auto first{ std::stoi(range.substr(0, dash)) };
+				auto last{ dash == std::string::npos ? first
+					: std::stoi(range.substr(dash + 1)) };
+				for (auto i{ first }; i <= last; i++) { ids.push_back(i); }
+			}
+			return ids;
+		}
+	}
+
+	/** \brief   Online CPUs from /sys/devices/system/cpu
+	 *  \details The node is the nodeN entry in the CPU directory. If a file
+	 *           is missing (containers often hide them), the value is 0. If
+	 *           there's no sysfs at all, every CPU is its own core. */
+	inline std::vector<Cpu> discover()
+	{
+		namespace fs = std::filesystem;
+		auto root{ fs::path("/sys/devices/system/cpu") };
+
+		auto online{ std::string{} };
+		std::getline(std::ifstream(root / "online"), online);
+		auto ids{ online.empty() ? std::vector<int>{}
+			: detail::parse_list(online) };
+		if (ids.empty())
+		{
+			auto n{ int(std::thread::hardware_concurrency()) };
+			for (int i{ 0 }; i < n; i++) { ids.push_back(i); }
+		}
+
+		auto cpus{ std::vector<Cpu>{} };
+		for (auto id : ids)
+		{
+			auto dir{ root / ("cpu" + std::to_string(id)) };
+			auto cpu{ Cpu{ id,
+				detail::read_int(dir / "topology/core_id", id),
+				detail::read_int(dir / "topology/physical_package_id", 0),
+				0 } };
+			auto error{ std::error_code{} };
+			for (auto& entry : fs::directory_iterator(dir, error))
+			{
+				auto name{ entry.path().filename().string() };
+				if (name.starts_with("node"))
+				{
+					cpu.node = std::stoi(name.substr(4));
+				}
+			}
+			cpus.push_back(cpu);
+		}
+		return cpus;
+	}
+
+	/** \brief CPUs for n threads as close as possible: one node, one
+	 *         package, the hyper-threads of one core first */
+	inline std::vector<Cpu> packed(std::vector<Cpu> cpus, std::size_t n)
+	{
+		std::stable_sort(cpus.begin(), cpus.end(),
+			[](const Cpu& a, const Cpu& b) {
+				return std::tie(a.node, a.package, a.core)
+					< std::tie(b.node, b.package, b.core); });
+		cpus.resize(std::min(n, cpus.size()));
+		return cpus;
+	}
+
+	/** \brief CPUs for n threads as far as possible: round-robin over the
+	 *         nodes and packages, different cores before hyper-threads */
+	inline std::vector<Cpu> spread(std::vector<Cpu> cpus, std::size_t n)
+	{
+		// Rank of the CPU inside its core and inside its package
+		auto sibling{ std::vector<int>(cpus.size()) };
+		auto in_package{ std::vector<int>(cpus.size()) };
+		for (std::size_t i{ 0 }; i < cpus.size(); i++)
+		{
+			for (std::size_t j{ 0 }; j < i; j++)
+			{
+				auto same_package{ cpus[i].package == cpus[j].package
+					&& cpus[i].node == cpus[j].node };
+				sibling[i] += same_package && cpus[i].core == cpus[j].core;
+				in_package[i] += same_package && sibling[j] == 0
+					&& cpus[i].core != cpus[j].core;
+			}
+		}
+
+		auto order{ std::vector<std::size_t>(cpus.size()) };
+		for (std::size_t i{ 0 }; i < order.size(); i++) { order[i] = i; }
+		std::stable_sort(order.begin(), order.end(),
+			[&](auto a, auto b) {
+				return std::tie(sibling[a], in_package[a])
+					< std::tie(sibling[b], in_package[b]); });
+
+		auto result{ std::vector<Cpu>{} };
+		for (std::size_t i{ 0 }; i < std::min(n, order.size()); i++)
+		{
+			result.push_back(cpus[order[i]]);
+		}
+		return result;
+	}
+}
+
+/** \brief Pins the calling thread to the CPU, returns false on failure */
+inline bool pin_current_thread(int cpu)
+{
+	auto set{ cpu_set_t{} };
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/** \brief   Starts a thread per CPU, pinned before f(index, cpu) is called
+ *  \details The thread pins itself first, so everything that f allocates
+ *           and touches is placed on the local NUMA node by the first-touch
+ *           policy of Linux. A CPU with a negative id means no pinning. */
+template<typename F>
+std::vector<std::thread> launch_pinned(const std::vector<Cpu>& cpus, F f)
+{
+	auto threads{ std::vector<std::thread>{} };
+	for (std::size_t i{ 0 }; i < cpus.size(); i++)
+	{
+		threads.push_back(std::thread{ [f, i, cpu = cpus[i]]() mutable {
+			if (cpu.id >= 0) { pin_current_thread(cpu.id); }
+			f(i, cpu);
+		} });
+	}
+	return threads;
+}
+
+/** \brief   Array allocated by the calling thread and filled right away
+ *  \details Memory pages are placed on the node of the thread that writes
+ *           them first, so a pinned thread gets the local memory. Call it
+ *           from the thread that uses the data. */
+template<typename T>
+std::unique_ptr<T[]> allocate_local(std::size_t n)
+{
+	return std::make_unique<T[]>(n);
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "CPU affinity and topology demo" << std::endl;
+
+	auto cpus{ topology::discover() };
+
+	{
+	std::cout << "online CPUs (cpu: core package node):" << std::endl;
+	for (auto& c : cpus)
+	{
+		std::cout << "  " << c.id << ": " << c.core << " " << c.package
+			<< " " << c.node << std::endl;
+	}
+
+	std::cout << "pinned thread: ";
+	auto t{ launch_pinned(topology::packed(cpus, 1),
+		[](std::size_t, Cpu cpu) {
+			std::cout << "asked for CPU " << cpu.id
+				<< ", running on " << sched_getcpu() << std::endl;
+		}) };
+	for (auto& _t : t) { _t.join(); }
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	auto count{ std::min<std::size_t>(4, cpus.size()) };
+	std::cout << std::endl << "Benchmark, " << count << " threads, " << n
+		<< " increments per thread, ms" << std::endl;
+	if (count < 2)
+	{
+		std::cout << "(one CPU only, placements are the same)" << std::endl;
+	}
+
+	auto run{
+		[&](const char* name, const std::vector<Cpu>& placement) -> void
+		{
+			// Shared state like in multithreading.cpp
+			auto m{ std::mutex{} };
+			auto v{ 0l };
+			auto a{ std::atomic<long>{ 0 } };
+			auto total{ std::atomic<long>{ 0 } };
+
+			auto go{ [&](auto&& body) {
+				return measure([&]() {
+					auto t{ launch_pinned(placement,
+						[&](std::size_t, Cpu) { body(); }) };
+					for (auto& _t : t) { _t.join(); } }); } };
+
+			auto mutex_ms{ go([&]() {
+				for (long i{ 0 }; i < n; i++)
+				{
+					auto lock{ std::lock_guard(m) };
+					v++;
+				} }) };
+			auto atomic_ms{ go([&]() {
+				for (long i{ 0 }; i < n; i++) { a++; } }) };
+			// Each thread counts in its own node-local memory and
+			// publishes the result once
+			auto local_ms{ go([&]() {
+				auto counter{ allocate_local<long>(1) };
+				// volatile keeps the loop from being folded
+				volatile long* p{ counter.get() };
+				for (long i{ 0 }; i < n; i++) { *p = *p + 1; }
+				total += counter[0]; }) };
+
+			auto expected{ long(placement.size()) * n };
+			std::cout << name << " mutex: " << mutex_ms
+				<< " atomic: " << atomic_ms
+				<< " thread-local: " << local_ms
+				<< (v == expected && a == expected && total == expected
+					? "" : " WRONG COUNT") << std::endl;
+		}
+	};
+
+	// Negative ids aren't pinned, the scheduler chooses
+	run("unpinned:", std::vector<Cpu>(count, Cpu{ -1, 0, 0, 0 }));
+	run("packed:", topology::packed(cpus, count));
+	run("spread:", topology::spread(cpus, count));
+	}
+
+	return 0;
+}
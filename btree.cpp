@@ -0,0 +1,1003 @@
+#include <iostream>
+#include <map>
+#include <vector>
+#include <array>
+#include <string>
+#include <random>
+#include <chrono>
+#include <compare>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+
+// std::map and std::set are red-black trees: a node per element, and a lookup
+// in a million elements visits about 20 nodes spread over the heap, each a
+// cache miss. A B+-tree keeps many keys per node, so the same lookup visits 4
+// or 5 nodes and searches a few cache lines inside each. The elements are
+// stored only in the leaves, and the leaves are linked, so a range scan walks
+// through arrays.
+
+/** \brief   Ordered map on a B+-tree
+ *  \details Inner nodes hold the keys and the children, leaves hold the keys
+ *           and the values in separate arrays and are linked both ways. A
+ *           node is about NodeBytes: 256 bytes are 4 cache lines, which the
+ *           hardware prefetcher fetches together. Keys and values must be
+ *           default constructible, the unused slots of a node hold default
+ *           values. Unlike std::map, insert and erase invalidate the
+ *           iterators, and the iterator returns a pair of references. */
+template<typename Key, typename T, typename Compare = std::less<Key>,
+	std::size_t NodeBytes = 256>
+class BTreeMap
+{
+	public:
+		static constexpr std::size_t LeafCapacity{ std::max<std::size_t>(4,
+			NodeBytes / (sizeof(Key) + sizeof(T))) };
+		static constexpr std::size_t InnerCapacity{ std::max<std::size_t>(4,
+			NodeBytes / (sizeof(Key) + sizeof(void*))) };
+
+	private:
+		static constexpr std::size_t LeafMin{ LeafCapacity / 2 };
+		static constexpr std::size_t InnerMin{ InnerCapacity / 2 };
+		// Every inner node has at least 3 children, so 48 levels are more
+		// than any memory can hold
+		static constexpr std::size_t MaxHeight{ 48 };
+
+		struct Node
+		{
+			std::size_t count{ 0 };
+		};
+
+		struct Leaf : Node
+		{
+			Leaf* prev{ nullptr };
+			Leaf* next{ nullptr };
+			std::array<Key, LeafCapacity> keys;
+			std::array<T, LeafCapacity> values;
+		};
+
+		// keys[i] is the smallest key of children[i + 1]
+		struct Inner : Node
+		{
+			std::array<Key, InnerCapacity> keys;
+			std::array<Node*, InnerCapacity + 1> children;
+		};
+
+		struct Step
+		{
+			Inner* node;
+			std::size_t index;
+		};
+
+		using Path = std::array<Step, MaxHeight>;
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using size_type = std::size_t;
+
+		template<bool Const>
+		class Iterator
+		{
+			public:
+				using iterator_concept = std::bidirectional_iterator_tag;
+				using iterator_category = std::input_iterator_tag;
+				using value_type = std::pair<const Key, T>;
+				using difference_type = std::ptrdiff_t;
+				using reference = std::pair<const Key&,
+					std::conditional_t<Const, const T&, T&>>;
+
+				struct Arrow
+				{
+					reference r;
+					reference* operator->() { return &r; }
+				};
+
+				Iterator() = default;
+
+				template<bool Other>
+					requires (Const && !Other)
+				Iterator(const Iterator<Other>& other)
+					: leaf(other.leaf), index(other.index), tree(other.tree)
+				{
+				}
+
+				reference operator*() const
+				{
+					return { leaf->keys[index], leaf->values[index] };
+				}
+
+				Arrow operator->() const { return { **this }; }
+
+				Iterator& operator++()
+				{
+					if (++index == leaf->count)
+					{
+						leaf = leaf->next;
+						index = 0;
+					}
+					return *this;
+				}
+
+				Iterator operator++(int)
+				{
+					auto copy{ *this };
+					++*this;
+					return copy;
+				}
+
+				Iterator& operator--()
+				{
+					if (!leaf || index == 0)
+					{
+						// From the end to the last leaf
+						leaf = leaf ? leaf->prev : tree->last;
+						index = leaf->count;
+					}
+					index--;
+					return *this;
+				}
+
+				Iterator operator--(int)
+				{
+					auto copy{ *this };
+					--*this;
+					return copy;
+				}
+
+				bool operator==(const Iterator& other) const
+				{
+					return leaf == other.leaf && index == other.index;
+				}
+
+			private:
+				friend class BTreeMap;
+				friend class Iterator<!Const>;
+
+				Iterator(Leaf* leaf, std::size_t index, const BTreeMap* tree)
+					: leaf(leaf), index(index), tree(tree)
+				{
+				}
+
+				Leaf* leaf{ nullptr };
+				std::size_t index{ 0 };
+				const BTreeMap* tree{ nullptr };
+		};
+
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		BTreeMap() = default;
+
+		BTreeMap(std::initializer_list<std::pair<Key, T>> values)
+		{
+			for (auto& [k, v] : values) { try_emplace(k, v); }
+		}
+
+		BTreeMap(const BTreeMap& other) { *this = other; }
+
+		BTreeMap(BTreeMap&& other) noexcept { swap(other); }
+
+		BTreeMap& operator=(const BTreeMap& other)
+		{
+			if (this != &other) { assign_sorted(other.begin(), other.end()); }
+			return *this;
+		}
+
+		BTreeMap& operator=(BTreeMap&& other) noexcept
+		{
+			auto moved{ BTreeMap(std::move(other)) };
+			swap(moved);
+			return *this;
+		}
+
+		~BTreeMap() { clear(); }
+
+		void swap(BTreeMap& other) noexcept
+		{
+			std::swap(root, other.root);
+			std::swap(first, other.first);
+			std::swap(last, other.last);
+			std::swap(height, other.height);
+			std::swap(elements, other.elements);
+		}
+
+		iterator begin() { return { first, 0, this }; }
+		iterator end() { return { nullptr, 0, this }; }
+		const_iterator begin() const { return { first, 0, this }; }
+		const_iterator end() const { return { nullptr, 0, this }; }
+
+		std::size_t size() const { return elements; }
+		bool empty() const { return elements == 0; }
+
+		/** \brief   Replaces the content with the sorted pairs
+		 *  \details Builds the tree bottom up in O(n): the leaves are
+		 *           filled in order and linked, then every level of the
+		 *           inner nodes is built over the previous one. Equal keys
+		 *           after the first one are skipped. */
+		template<typename It>
+		void assign_sorted(It from, It to)
+		{
+			auto items{ std::vector<std::pair<Key, T>>{} };
+			for (; from != to; ++from)
+			{
+				auto&& [k, v]{ *from };
+				if (items.empty() || compare(items.back().first, k))
+				{
+					items.emplace_back(k, v);
+				}
+			}
+			clear();
+			if (items.empty()) { return; }
+
+			auto level{ std::vector<Node*>{} };
+			auto minimums{ std::vector<Key>{} };
+			auto sizes{ spread(items.size(), LeafCapacity) };
+			auto next{ items.begin() };
+			for (auto size : sizes)
+			{
+				auto* leaf{ new Leaf{} };
+				for (std::size_t i{ 0 }; i < size; i++, ++next)
+				{
+					leaf->keys[i] = std::move(next->first);
+					leaf->values[i] = std::move(next->second);
+				}
+				leaf->count = size;
+				leaf->prev = last;
+				if (last) { last->next = leaf; }
+				else { first = leaf; }
+				last = leaf;
+				level.push_back(leaf);
+				minimums.push_back(leaf->keys[0]);
+			}
+			elements = items.size();
+
+			while (level.size() > 1)
+			{
+				auto upper{ std::vector<Node*>{} };
+				auto upper_minimums{ std::vector<Key>{} };
+				auto child{ std::size_t{ 0 } };
+				for (auto size : spread(level.size(), InnerCapacity + 1))
+				{
+					auto* inner{ new Inner{} };
+					upper_minimums.push_back(minimums[child]);
+					for (std::size_t i{ 0 }; i < size; i++, child++)
+					{
+						inner->children[i] = level[child];
+						if (i > 0) { inner->keys[i - 1] = minimums[child]; }
+					}
+					inner->count = size - 1;
+					upper.push_back(inner);
+				}
+				level = std::move(upper);
+				minimums = std::move(upper_minimums);
+				height++;
+			}
+			root = level.front();
+		}
+
+		const_iterator find(const Key& key) const
+		{
+			if (!root) { return end(); }
+			auto* leaf{ find_leaf(key, nullptr) };
+			auto i{ position(leaf, key) };
+			if (i == leaf->count || compare(key, leaf->keys[i]))
+			{
+				return end();
+			}
+			return { leaf, i, this };
+		}
+
+		iterator find(const Key& key)
+		{
+			auto it{ std::as_const(*this).find(key) };
+			return { it.leaf, it.index, this };
+		}
+
+		/** \brief The first element not less than the key */
+		const_iterator lower_bound(const Key& key) const
+		{
+			if (!root) { return end(); }
+			auto* leaf{ find_leaf(key, nullptr) };
+			auto i{ position(leaf, key) };
+			// Past the end of the leaf: the next leaf starts with the
+			// answer
+			if (i == leaf->count) { return { leaf->next, 0, this }; }
+			return { leaf, i, this };
+		}
+
+		bool contains(const Key& key) const { return find(key) != end(); }
+
+		std::size_t count(const Key& key) const { return contains(key); }
+
+		T& at(const Key& key)
+		{
+			auto it{ find(key) };
+			if (it == end()) { throw std::out_of_range("BTreeMap::at"); }
+			return (*it).second;
+		}
+
+		T& operator[](const Key& key)
+		{
+			return (*try_emplace(key).first).second;
+		}
+
+		T& operator[](Key&& key)
+		{
+			return (*try_emplace(std::move(key)).first).second;
+		}
+
+		std::pair<iterator, bool> insert(std::pair<Key, T> value)
+		{
+			return try_emplace(std::move(value.first), std::move(value.second));
+		}
+
+		/** \brief Inserts the value made of args if the key is missing */
+		template<typename K, typename... Args>
+		std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+		{
+			if (!root)
+			{
+				auto* leaf{ new Leaf{} };
+				root = first = last = leaf;
+			}
+			auto path{ Path{} };
+			auto* leaf{ find_leaf(key, &path) };
+			auto i{ position(leaf, key) };
+			if (i < leaf->count && !compare(key, leaf->keys[i]))
+			{
+				return { { leaf, i, this }, false };
+			}
+
+			if (leaf->count == LeafCapacity)
+			{
+				auto* right{ split(leaf) };
+				insert_into_parent(path, leaf, right->keys[0], right);
+				if (i > leaf->count)
+				{
+					i -= leaf->count;
+					leaf = right;
+				}
+			}
+
+			auto n{ leaf->count };
+			std::move_backward(leaf->keys.begin() + i,
+				leaf->keys.begin() + n, leaf->keys.begin() + n + 1);
+			std::move_backward(leaf->values.begin() + i,
+				leaf->values.begin() + n, leaf->values.begin() + n + 1);
+			leaf->keys[i] = Key(std::forward<K>(key));
+			leaf->values[i] = T(std::forward<Args>(args)...);
+			leaf->count++;
+			elements++;
+			return { { leaf, i, this }, true };
+		}
+
+		/** \brief Removes the key, returns the number of removed elements */
+		std::size_t erase(const Key& key)
+		{
+			if (!root) { return 0; }
+			auto path{ Path{} };
+			auto* leaf{ find_leaf(key, &path) };
+			auto i{ position(leaf, key) };
+			if (i == leaf->count || compare(key, leaf->keys[i])) { return 0; }
+
+			auto n{ leaf->count };
+			std::move(leaf->keys.begin() + i + 1, leaf->keys.begin() + n,
+				leaf->keys.begin() + i);
+			std::move(leaf->values.begin() + i + 1, leaf->values.begin() + n,
+				leaf->values.begin() + i);
+			leaf->keys[n - 1] = Key{};
+			leaf->values[n - 1] = T{};
+			leaf->count--;
+			elements--;
+			rebalance(leaf, path);
+			return 1;
+		}
+
+		/** \brief Removes the element, returns the iterator to the next one */
+		iterator erase(const_iterator pos)
+		{
+			auto key{ Key((*pos).first) };
+			erase(key);
+			auto it{ lower_bound(key) };
+			return { it.leaf, it.index, this };
+		}
+
+		/** \brief   Moves the elements whose keys are missing here from the
+		 *           other map, like std::map::merge
+		 *  \details The other map keeps the elements with the keys that are
+		 *           here, it's rebuilt from them in O(n). */
+		void merge(BTreeMap& other)
+		{
+			if (&other == this) { return; }
+			auto rest{ std::vector<std::pair<Key, T>>{} };
+			for (auto* leaf{ other.first }; leaf; leaf = leaf->next)
+			{
+				for (std::size_t i{ 0 }; i < leaf->count; i++)
+				{
+					auto& key{ leaf->keys[i] };
+					auto& value{ leaf->values[i] };
+					if (contains(key))
+					{
+						rest.emplace_back(std::move(key), std::move(value));
+					}
+					else
+					{
+						try_emplace(std::move(key), std::move(value));
+					}
+				}
+			}
+			other.assign_sorted(rest.begin(), rest.end());
+		}
+
+		void clear()
+		{
+			if (root) { destroy(root, height); }
+			root = nullptr;
+			first = last = nullptr;
+			height = 0;
+			elements = 0;
+		}
+
+		friend bool operator==(const BTreeMap& a, const BTreeMap& b)
+		{
+			return a.size() == b.size()
+				&& std::equal(a.begin(), a.end(), b.begin(), b.end());
+		}
+
+		friend auto operator<=>(const BTreeMap& a, const BTreeMap& b)
+		{
+			return std::lexicographical_compare_three_way(a.begin(), a.end(),
+				b.begin(), b.end());
+		}
+
+	private:
+		// Sizes of the nodes for n items, as even as possible and full
+		// up to the capacity, so no node but a single one is underfull
+		static std::vector<std::size_t> spread(std::size_t n,
+			std::size_t capacity)
+		{
+			auto nodes{ (n + capacity - 1) / capacity };
+			auto sizes{ std::vector<std::size_t>(nodes, n / nodes) };
+			for (std::size_t i{ 0 }; i < n % nodes; i++) { sizes[i]++; }
+			return sizes;
+		}
+
+		static Leaf* as_leaf(Node* n) { return static_cast<Leaf*>(n); }
+		static Inner* as_inner(Node* n) { return static_cast<Inner*>(n); }
+
+		std::size_t position(const Leaf* leaf, const Key& key) const
+		{
+			return std::lower_bound(leaf->keys.begin(),
+				leaf->keys.begin() + leaf->count, key, compare)
+				- leaf->keys.begin();
+		}
+
+		// Goes down to the leaf of the key, remembering the way
+		Leaf* find_leaf(const Key& key, Path* path) const
+		{
+			auto* node{ root };
+			for (std::size_t level{ 0 }; level < height; level++)
+			{
+				auto* inner{ as_inner(node) };
+				auto i{ std::size_t(std::upper_bound(inner->keys.begin(),
+					inner->keys.begin() + inner->count, key, compare)
+					- inner->keys.begin()) };
+				if (path) { (*path)[level] = { inner, i }; }
+				node = inner->children[i];
+			}
+			return as_leaf(node);
+		}
+
+		// Moves the upper half of the leaf into a new leaf after it
+		Leaf* split(Leaf* leaf)
+		{
+			auto* right{ new Leaf{} };
+			auto half{ leaf->count / 2 };
+			for (auto i{ half }; i < leaf->count; i++)
+			{
+				right->keys[i - half] = std::exchange(leaf->keys[i], Key{});
+				right->values[i - half] = std::exchange(leaf->values[i], T{});
+			}
+			right->count = leaf->count - half;
+			leaf->count = half;
+			right->prev = leaf;
+			right->next = leaf->next;
+			if (leaf->next) { leaf->next->prev = right; }
+			else { last = right; }
+			leaf->next = right;
+			return right;
+		}
+
+		// Adds the right node after the left one into the parents,
+		// splitting the full ones up to the root
+		void insert_into_parent(const Path& path, Node* left, Key separator,
+			Node* right)
+		{
+			for (auto level{ height }; level-- > 0;)
+			{
+				auto [inner, i]{ path[level] };
+				auto n{ inner->count };
+				if (n < InnerCapacity)
+				{
+					std::move_backward(inner->keys.begin() + i,
+						inner->keys.begin() + n, inner->keys.begin() + n + 1);
+					std::move_backward(inner->children.begin() + i + 1,
+						inner->children.begin() + n + 1,
+						inner->children.begin() + n + 2);
+					inner->keys[i] = std::move(separator);
+					inner->children[i + 1] = right;
+					inner->count++;
+					return;
+				}
+
+				// Full: lay out all of the keys and children in order,
+				// the middle key goes up
+				auto keys{ std::array<Key, InnerCapacity + 1>{} };
+				auto children{ std::array<Node*, InnerCapacity + 2>{} };
+				for (std::size_t k{ 0 }, j{ 0 }; k <= n; k++)
+				{
+					if (k == i) { keys[k] = std::move(separator); }
+					else { keys[k] = std::move(inner->keys[j++]); }
+				}
+				for (std::size_t k{ 0 }, j{ 0 }; k <= n + 1; k++)
+				{
+					children[k] = k == i + 1 ? right : inner->children[j++];
+				}
+
+				auto middle{ (n + 1) / 2 };
+				auto* sibling{ new Inner{} };
+				inner->count = middle;
+				sibling->count = n - middle;
+				for (std::size_t k{ 0 }; k < middle; k++)
+				{
+					inner->keys[k] = std::move(keys[k]);
+				}
+				for (std::size_t k{ middle }; k < InnerCapacity; k++)
+				{
+					inner->keys[k] = Key{};
+				}
+				for (std::size_t k{ 0 }; k <= middle; k++)
+				{
+					inner->children[k] = children[k];
+				}
+				for (std::size_t k{ 0 }; k < sibling->count; k++)
+				{
+					sibling->keys[k] = std::move(keys[middle + 1 + k]);
+				}
+				for (std::size_t k{ 0 }; k <= sibling->count; k++)
+				{
+					sibling->children[k] = children[middle + 1 + k];
+				}
+				left = inner;
+				right = sibling;
+				separator = std::move(keys[middle]);
+			}
+
+			auto* top{ new Inner{} };
+			top->keys[0] = std::move(separator);
+			top->children[0] = left;
+			top->children[1] = right;
+			top->count = 1;
+			root = top;
+			height++;
+		}
+
+		// Removes the key i and the child i + 1 of the inner node
+		static void remove_from(Inner* inner, std::size_t i)
+		{
+			auto n{ inner->count };
+			std::move(inner->keys.begin() + i + 1, inner->keys.begin() + n,
+				inner->keys.begin() + i);
+			std::move(inner->children.begin() + i + 2,
+				inner->children.begin() + n + 1,
+				inner->children.begin() + i + 1);
+			inner->keys[n - 1] = Key{};
+			inner->count--;
+		}
+
+		// Appends the right leaf to the left one and deletes it
+		void join(Leaf* left, Leaf* right)
+		{
+			for (std::size_t i{ 0 }; i < right->count; i++)
+			{
+				left->keys[left->count + i] = std::move(right->keys[i]);
+				left->values[left->count + i] = std::move(right->values[i]);
+			}
+			left->count += right->count;
+			left->next = right->next;
+			if (right->next) { right->next->prev = left; }
+			else { last = left; }
+			delete right;
+		}
+
+		// After erase: an underfull leaf borrows an element from a
+		// neighbour with the same parent or is merged with it
+		void rebalance(Leaf* leaf, const Path& path)
+		{
+			if (height == 0)
+			{
+				if (leaf->count == 0) { clear(); }
+				return;
+			}
+			if (leaf->count >= LeafMin) { return; }
+
+			auto [parent, i]{ path[height - 1] };
+			auto* left{ i > 0 ? as_leaf(parent->children[i - 1]) : nullptr };
+			auto* right{ i < parent->count
+				? as_leaf(parent->children[i + 1]) : nullptr };
+
+			if (left && left->count > LeafMin)
+			{
+				auto n{ leaf->count };
+				std::move_backward(leaf->keys.begin(),
+					leaf->keys.begin() + n, leaf->keys.begin() + n + 1);
+				std::move_backward(leaf->values.begin(),
+					leaf->values.begin() + n, leaf->values.begin() + n + 1);
+				left->count--;
+				leaf->keys[0] = std::exchange(left->keys[left->count], Key{});
+				leaf->values[0] = std::exchange(left->values[left->count], T{});
+				leaf->count++;
+				parent->keys[i - 1] = leaf->keys[0];
+				return;
+			}
+			if (right && right->count > LeafMin)
+			{
+				leaf->keys[leaf->count] = std::move(right->keys[0]);
+				leaf->values[leaf->count] = std::move(right->values[0]);
+				leaf->count++;
+				auto n{ right->count };
+				std::move(right->keys.begin() + 1, right->keys.begin() + n,
+					right->keys.begin());
+				std::move(right->values.begin() + 1,
+					right->values.begin() + n, right->values.begin());
+				right->keys[n - 1] = Key{};
+				right->values[n - 1] = T{};
+				right->count--;
+				parent->keys[i] = right->keys[0];
+				return;
+			}
+
+			if (left) { join(left, leaf); remove_from(parent, i - 1); }
+			else { join(leaf, right); remove_from(parent, i); }
+			rebalance(path, height - 1);
+		}
+
+		// The same for the inner node at the level of the path
+		void rebalance(const Path& path, std::size_t level)
+		{
+			auto* inner{ path[level].node };
+			if (level == 0)
+			{
+				// The root with one child gives its place to the child
+				if (inner->count == 0)
+				{
+					root = inner->children[0];
+					delete inner;
+					height--;
+				}
+				return;
+			}
+			if (inner->count >= InnerMin) { return; }
+
+			auto [parent, i]{ path[level - 1] };
+			auto* left{ i > 0 ? as_inner(parent->children[i - 1]) : nullptr };
+			auto* right{ i < parent->count
+				? as_inner(parent->children[i + 1]) : nullptr };
+			auto n{ inner->count };
+
+			// Borrowing goes through the parent: its key comes down, the
+			// neighbour's edge key goes up
+			if (left && left->count > InnerMin)
+			{
+				std::move_backward(inner->keys.begin(),
+					inner->keys.begin() + n, inner->keys.begin() + n + 1);
+				std::move_backward(inner->children.begin(),
+					inner->children.begin() + n + 1,
+					inner->children.begin() + n + 2);
+				inner->keys[0] = std::move(parent->keys[i - 1]);
+				inner->children[0] = left->children[left->count];
+				inner->count++;
+				parent->keys[i - 1] = std::exchange(
+					left->keys[left->count - 1], Key{});
+				left->count--;
+				return;
+			}
+			if (right && right->count > InnerMin)
+			{
+				inner->keys[n] = std::move(parent->keys[i]);
+				inner->children[n + 1] = right->children[0];
+				inner->count++;
+				parent->keys[i] = std::move(right->keys[0]);
+				auto m{ right->count };
+				std::move(right->keys.begin() + 1, right->keys.begin() + m,
+					right->keys.begin());
+				std::move(right->children.begin() + 1,
+					right->children.begin() + m + 1, right->children.begin());
+				right->keys[m - 1] = Key{};
+				right->count--;
+				return;
+			}
+
+			// Merge: the separator from the parent comes between them
+			auto* a{ left ? left : inner };
+			auto* b{ left ? inner : right };
+			auto separator{ left ? i - 1 : i };
+			a->keys[a->count] = std::move(parent->keys[separator]);
+			for (std::size_t k{ 0 }; k < b->count; k++)
+			{
+				a->keys[a->count + 1 + k] = std::move(b->keys[k]);
+			}
+			for (std::size_t k{ 0 }; k <= b->count; k++)
+			{
+				a->children[a->count + 1 + k] = b->children[k];
+			}
+			a->count += 1 + b->count;
+			delete b;
+			remove_from(parent, separator);
+			rebalance(path, level - 1);
+		}
+
+		static void destroy(Node* node, std::size_t height)
+		{
+			if (height == 0)
+			{
+				delete as_leaf(node);
+				return;
+			}
+			auto* inner{ as_inner(node) };
+			for (std::size_t i{ 0 }; i <= inner->count; i++)
+			{
+				destroy(inner->children[i], height - 1);
+			}
+			delete inner;
+		}
+
+		Node* root{ nullptr };
+		Leaf* first{ nullptr };
+		Leaf* last{ nullptr };
+		std::size_t height{ 0 };  // Levels of inner nodes
+		std::size_t elements{ 0 };
+		[[no_unique_address]] Compare compare;
+};
+
+/** \brief Ordered set on the B+-tree of BTreeMap */
+template<typename Key, typename Compare = std::less<Key>,
+	std::size_t NodeBytes = 256>
+class BTreeSet
+{
+	struct Empty
+	{
+		auto operator<=>(const Empty&) const = default;
+	};
+
+	using Map = BTreeMap<Key, Empty, Compare, NodeBytes>;
+
+	public:
+		class iterator
+		{
+			public:
+				using iterator_concept = std::bidirectional_iterator_tag;
+				using iterator_category = std::bidirectional_iterator_tag;
+				using value_type = Key;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const Key*;
+				using reference = const Key&;
+
+				iterator() = default;
+
+				const Key& operator*() const { return (*it).first; }
+				const Key* operator->() const { return &(*it).first; }
+
+				iterator& operator++() { ++it; return *this; }
+				iterator& operator--() { --it; return *this; }
+
+				iterator operator++(int)
+				{
+					auto copy{ *this };
+					++it;
+					return copy;
+				}
+
+				iterator operator--(int)
+				{
+					auto copy{ *this };
+					--it;
+					return copy;
+				}
+
+				bool operator==(const iterator&) const = default;
+
+			private:
+				friend class BTreeSet;
+				iterator(typename Map::const_iterator it) : it(it) {}
+				typename Map::const_iterator it;
+		};
+
+		using const_iterator = iterator;
+
+		BTreeSet() = default;
+
+		BTreeSet(std::initializer_list<Key> keys)
+		{
+			for (auto& k : keys) { insert(k); }
+		}
+
+		iterator begin() const { return map.begin(); }
+		iterator end() const { return map.end(); }
+
+		std::size_t size() const { return map.size(); }
+		bool empty() const { return map.empty(); }
+
+		/** \brief Replaces the content with the sorted keys in O(n) */
+		template<typename It>
+		void assign_sorted(It from, It to)
+		{
+			auto pairs{ std::vector<std::pair<Key, Empty>>{} };
+			for (; from != to; ++from) { pairs.emplace_back(*from, Empty{}); }
+			map.assign_sorted(pairs.begin(), pairs.end());
+		}
+
+		std::pair<iterator, bool> insert(Key key)
+		{
+			auto [it, inserted]{ map.try_emplace(std::move(key)) };
+			return { typename Map::const_iterator(it), inserted };
+		}
+
+		std::size_t erase(const Key& key) { return map.erase(key); }
+
+		iterator find(const Key& key) const { return map.find(key); }
+		iterator lower_bound(const Key& key) const
+		{
+			return map.lower_bound(key);
+		}
+		bool contains(const Key& key) const { return map.contains(key); }
+		std::size_t count(const Key& key) const { return map.contains(key); }
+
+		void merge(BTreeSet& other) { map.merge(other.map); }
+
+		void clear() { map.clear(); }
+
+		friend bool operator==(const BTreeSet&, const BTreeSet&) = default;
+
+		friend auto operator<=>(const BTreeSet& a, const BTreeSet& b)
+		{
+			return std::lexicographical_compare_three_way(a.begin(), a.end(),
+				b.begin(), b.end());
+		}
+
+	private:
+		Map map;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "B+-tree map and set demo" << std::endl;
+
+	auto compare{ [](auto& x, auto& y) {
+		return (x <=> y) == 0 ? "x == y" : (x <=> y) < 0 ? "x <  y" : "x >  y";
+	} };
+
+	{
+	// The same steps as the std::set demo in containers.cpp
+	auto x{ BTreeSet<std::string>{ "foo", "bar", "baz" } };
+	auto z{ BTreeSet<std::string>{ "x", "y", "z" } };
+	x.insert("foo");
+	x.insert("fff");
+	x.erase("fff");
+	x.erase("fff");
+	std::cout << "set size: " << x.size() << ", count: " << x.count("foo")
+		<< ", contains: " << x.contains("foo") << ", find: "
+		<< *x.find("foo") << std::endl;
+
+	auto k{ z };
+	k.insert("foo");
+	k.merge(x);
+	std::cout << "merged: ";
+	for (auto& s : k) { std::cout << s << " "; }
+	std::cout << "left in x: ";
+	for (auto& s : x) { std::cout << s << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	// The same steps as the std::map demo in containers.cpp
+	auto x{ BTreeMap<std::string, int>{
+		{ "foo", 1 }, { "bar", 2 }, { "baz", 3 } } };
+	auto y{ x };
+	auto z{ BTreeMap<std::string, int>() };
+	std::cout << "map access: " << x["foo"];
+	z["bax"] = 10;
+	x["foo"] = 0;
+	std::cout << ", missing item: " << x["xxx"] << ", now contains it: "
+		<< x.contains("xxx");
+	z.erase("bax");
+	std::cout << ", z is empty: " << z.empty() << std::endl;
+
+	x.erase("xxx");
+	y["foo"] = x["foo"];
+	std::cout << "comparing maps: " << compare(x, y);
+	x["foo"] = 1;
+	std::cout << ", " << compare(x, y);
+	x["foo"] = 0;
+	y["foo"] = 1;
+	std::cout << ", " << compare(x, y) << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	std::cout << std::endl << "Benchmark, " << n << " random 64-bit keys, "
+		<< BTreeMap<std::uint64_t, std::uint64_t>::LeafCapacity
+		<< " per leaf, ms" << std::endl;
+
+	auto generator{ std::mt19937_64{ 42 } };
+	auto keys{ std::vector<std::uint64_t>(n) };
+	for (auto& k : keys) { k = generator(); }
+	auto sorted{ keys };
+	std::sort(sorted.begin(), sorted.end());
+	auto pairs{ std::vector<std::pair<std::uint64_t, std::uint64_t>>{} };
+	for (auto k : sorted) { pairs.emplace_back(k, k / 2); }
+	auto starts{ std::vector<std::uint64_t>(1000) };
+	for (auto& s : starts) { s = generator(); }
+
+	// The same steps for both maps. The checksums must be equal.
+	auto run{ [&](const char* name, auto& map, auto build) {
+		auto checksum{ 0ul };
+		auto insert_ms{ measure([&]() {
+			for (auto k : keys) { map[k] = k / 2; } }) };
+		auto find_ms{ measure([&]() {
+			for (auto k : keys) { checksum += (*map.find(k)).second; } }) };
+		auto scan_ms{ measure([&]() {
+			for (auto [k, v] : map) { checksum += v; } }) };
+		// 1000 short range queries of 100 elements
+		auto range_ms{ measure([&]() {
+			for (auto s : starts)
+			{
+				auto it{ map.lower_bound(s) };
+				for (int i{ 0 }; i < 100 && it != map.end(); i++, ++it)
+				{
+					checksum += (*it).first;
+				}
+			} }) };
+		auto erase_ms{ measure([&]() {
+			for (long i{ 0 }; i < n; i += 2) { map.erase(keys[i]); } }) };
+		checksum += map.size();
+		map.clear();
+		auto bulk_ms{ measure([&]() { build(); }) };
+		checksum += map.size();
+
+		std::cout << name << ": insert: " << insert_ms << " find: "
+			<< find_ms << " scan: " << scan_ms << " ranges: " << range_ms
+			<< " erase half: " << erase_ms << " from sorted: " << bulk_ms
+			<< std::endl;
+		return checksum;
+	} };
+
+	auto std_map{ std::map<std::uint64_t, std::uint64_t>{} };
+	auto tree_map{ BTreeMap<std::uint64_t, std::uint64_t>{} };
+	// std::map gets the sorted input through the end hint, which is its
+	// fastest way to build
+	auto std_checksum{ run("std::map", std_map, [&]() {
+		for (auto& p : pairs) { std_map.emplace_hint(std_map.end(), p); } }) };
+	auto tree_checksum{ run("BTreeMap", tree_map, [&]() {
+		tree_map.assign_sorted(pairs.begin(), pairs.end()); }) };
+	std::cout << (std_checksum == tree_checksum
+		? "results match" : "RESULTS DIFFER") << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,538 @@
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <span>
+#include <bit>
+#include <string>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <ranges>
+#include <algorithm>
+#include <initializer_list>
+
+/** \brief   Double-ended queue with a compile-time block size
+ *  \details Elements live in fixed-size blocks referenced from a map of
+ *           block pointers, like std::deque, but the block size is chosen
+ *           by the user instead of being fixed to 512 bytes. The block
+ *           size is a power of two, so locating an element is a shift and
+ *           a mask. Every block is a contiguous segment, which may be
+ *           walked with for_each_segment() to run plain (vectorizable)
+ *           loops over the whole container.
+ *  \tparam  T         Type of the stored elements
+ *  \tparam  BlockSize Number of elements in one block, power of two */
+template<typename T, std::size_t BlockSize = 1024>
+class ChunkedDeque
+{
+	static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0,
+		"BlockSize should be a power of two");
+
+	static constexpr std::size_t shift{ std::countr_zero(BlockSize) };
+	static constexpr std::size_t mask{ BlockSize - 1 };
+
+	public:
+		/** \brief   Random access iterator
+		 *  \details Holds the owner and the element index, so it stays
+		 *           valid while the map grows */
+		template<bool Const>
+		class Iterator
+		{
+			using Owner = std::conditional_t<Const,
+				const ChunkedDeque, ChunkedDeque>;
+
+			public:
+				using iterator_category =
+					std::random_access_iterator_tag;
+				using value_type = T;
+				using difference_type = std::ptrdiff_t;
+				using pointer = std::conditional_t<Const,
+					const T*, T*>;
+				using reference = std::conditional_t<Const,
+					const T&, T&>;
+
+				Iterator() = default;
+				Iterator(Owner* owner, std::size_t index)
+					: owner(owner), index(index) {}
+
+				operator Iterator<true>() const requires (!Const)
+				{
+					return Iterator<true>(owner, index);
+				}
+
+				reference operator*() const
+				{ return (*owner)[index]; }
+				pointer operator->() const
+				{ return &(*owner)[index]; }
+				reference operator[](difference_type n) const
+				{ return (*owner)[index + n]; }
+
+				Iterator& operator++() { index++; return *this; }
+				Iterator& operator--() { index--; return *this; }
+				Iterator operator++(int)
+				{ auto i{ *this }; index++; return i; }
+				Iterator operator--(int)
+				{ auto i{ *this }; index--; return i; }
+				Iterator& operator+=(difference_type n)
+				{ index += n; return *this; }
+				Iterator& operator-=(difference_type n)
+				{ index -= n; return *this; }
+
+				friend Iterator operator+(Iterator i,
+						difference_type n)
+				{ return i += n; }
+				friend Iterator operator+(difference_type n,
+						Iterator i)
+				{ return i += n; }
+				friend Iterator operator-(Iterator i,
+						difference_type n)
+				{ return i -= n; }
+				friend difference_type operator-(
+						const Iterator& a, const Iterator& b)
+				{
+					return static_cast<difference_type>(a.index)
+						- static_cast<difference_type>(b.index);
+				}
+
+				friend bool operator==(const Iterator& a,
+						const Iterator& b)
+				{ return a.index == b.index; }
+				friend auto operator<=>(const Iterator& a,
+						const Iterator& b)
+				{ return a.index <=> b.index; }
+
+				/** \brief Position of the element in the owner */
+				std::size_t position() const { return index; }
+
+			private:
+				Owner* owner{ nullptr };
+				std::size_t index{ 0 };
+		};
+
+		using value_type = T;
+		using size_type = std::size_t;
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		ChunkedDeque() = default;
+
+		ChunkedDeque(std::initializer_list<T> init)
+		{
+			for (auto& i : init) { push_back(i); }
+		}
+
+		ChunkedDeque(const ChunkedDeque& obj)
+		{
+			for (auto& i : obj) { push_back(i); }
+		}
+
+		ChunkedDeque(ChunkedDeque&& obj) noexcept { swap(obj); }
+
+		ChunkedDeque& operator=(ChunkedDeque obj) noexcept
+		{
+			swap(obj);
+			return *this;
+		}
+
+		ChunkedDeque& operator=(std::initializer_list<T> init)
+		{
+			clear();
+			for (auto& i : init) { push_back(i); }
+			return *this;
+		}
+
+		/** \brief   Destructor
+		 *  \details Destroys the elements and frees all of the blocks */
+		~ChunkedDeque()
+		{
+			clear();
+			for (auto block : map) { alloc.deallocate(block, BlockSize); }
+		}
+
+		void swap(ChunkedDeque& obj) noexcept
+		{
+			std::swap(map, obj.map);
+			std::swap(head, obj.head);
+			std::swap(count, obj.count);
+		}
+
+		T& operator[](std::size_t i) { return *slot(head + i); }
+		const T& operator[](std::size_t i) const
+		{ return *slot(head + i); }
+
+		T& front() { return (*this)[0]; }
+		T& back() { return (*this)[count - 1]; }
+		const T& front() const { return (*this)[0]; }
+		const T& back() const { return (*this)[count - 1]; }
+
+		std::size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, count); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const
+		{ return const_iterator(this, count); }
+
+		template<typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (head + count == map.size() * BlockSize) { grow_back(); }
+			auto p{ std::construct_at(slot(head + count),
+				std::forward<Args>(args)...) };
+			count++;
+			return *p;
+		}
+
+		template<typename... Args>
+		T& emplace_front(Args&&... args)
+		{
+			if (head == 0) { grow_front(); }
+			auto p{ std::construct_at(slot(head - 1),
+				std::forward<Args>(args)...) };
+			head--;
+			count++;
+			return *p;
+		}
+
+		void push_back(const T& value) { emplace_back(value); }
+		void push_back(T&& value) { emplace_back(std::move(value)); }
+		void push_front(const T& value) { emplace_front(value); }
+		void push_front(T&& value) { emplace_front(std::move(value)); }
+
+		void pop_back()
+		{
+			std::destroy_at(slot(head + count - 1));
+			count--;
+		}
+
+		void pop_front()
+		{
+			std::destroy_at(slot(head));
+			head++;
+			count--;
+		}
+
+		/** \brief   Inserts the value before pos
+		 *  \details Shifts the shorter side of the container, block by
+		 *           block, so the cost is half of the distance to the
+		 *           nearest end at worst */
+		iterator insert(const_iterator pos, T value)
+		{
+			auto i{ pos.position() };
+			if (i == count) { push_back(std::move(value)); }
+			else if (i == 0) { push_front(std::move(value)); }
+			else if (i >= count / 2)
+			{
+				push_back(std::move(back()));
+				shift_back(i, count - 2);
+				(*this)[i] = std::move(value);
+			}
+			else
+			{
+				push_front(std::move(front()));
+				shift_front(2, i + 1);
+				(*this)[i] = std::move(value);
+			}
+			return iterator(this, i);
+		}
+
+		/** \brief Erases the element at pos, shifting the shorter side */
+		iterator erase(const_iterator pos)
+		{
+			auto i{ pos.position() };
+			if (i < count / 2)
+			{
+				shift_back(0, i);
+				pop_front();
+			}
+			else
+			{
+				shift_front(i + 1, count);
+				pop_back();
+			}
+			return iterator(this, i);
+		}
+
+		/** \brief   Destroys all of the elements
+		 *  \details The blocks are kept for the further use */
+		void clear()
+		{
+			while (count) { pop_back(); }
+			head = map.size() / 2 * BlockSize;
+		}
+
+		/** \brief   Calls f with every contiguous segment of elements
+		 *  \details f receives std::span<T>, at most BlockSize items
+		 *           long. Loops inside f see a plain array, so the
+		 *           compiler is free to vectorize them. */
+		template<typename F>
+		void for_each_segment(F&& f)
+		{
+			auto pos{ head };
+			auto last{ head + count };
+			while (pos < last)
+			{
+				auto n{ std::min(BlockSize - (pos & mask), last - pos) };
+				f(std::span<T>(slot(pos), n));
+				pos += n;
+			}
+		}
+
+		template<typename F>
+		void for_each_segment(F&& f) const
+		{
+			auto pos{ head };
+			auto last{ head + count };
+			while (pos < last)
+			{
+				auto n{ std::min(BlockSize - (pos & mask), last - pos) };
+				f(std::span<const T>(slot(pos), n));
+				pos += n;
+			}
+		}
+
+	private:
+		T* slot(std::size_t pos) const
+		{
+			return map[pos >> shift] + (pos & mask);
+		}
+
+		// Moves [first, last) one place towards the back. The slot at
+		// last should hold an alive object.
+		void shift_back(std::size_t first, std::size_t last)
+		{
+			auto pos{ last };
+			while (pos > first)
+			{
+				auto off{ (head + pos) & mask };
+				if (off == 0)
+				{
+					(*this)[pos] = std::move((*this)[pos - 1]);
+					pos--;
+					continue;
+				}
+				auto n{ std::min(off, pos - first) };
+				auto p{ slot(head + pos) - off };
+				std::move_backward(p + off - n, p + off, p + off + 1);
+				pos -= n;
+			}
+		}
+
+		// Moves [first, last) one place towards the front. The slot at
+		// first - 1 should hold an alive object.
+		void shift_front(std::size_t first, std::size_t last)
+		{
+			auto pos{ first };
+			while (pos < last)
+			{
+				auto off{ (head + pos) & mask };
+				if (off == 0)
+				{
+					(*this)[pos - 1] = std::move((*this)[pos]);
+					pos++;
+					continue;
+				}
+				auto n{ std::min(BlockSize - off, last - pos) };
+				auto p{ slot(head + pos) - off };
+				std::move(p + off, p + off + n, p + off - 1);
+				pos += n;
+			}
+		}
+
+		// Reuses a free block from the front if there is one,
+		// otherwise doubles the map.
+		void grow_back()
+		{
+			if (head >= BlockSize)
+			{
+				std::rotate(map.begin(), map.begin() + 1, map.end());
+				head -= BlockSize;
+				return;
+			}
+			auto n{ std::max<std::size_t>(1, map.size()) };
+			for (std::size_t i{ 0 }; i < n; i++)
+			{
+				map.push_back(alloc.allocate(BlockSize));
+			}
+		}
+
+		void grow_front()
+		{
+			if (map.size() * BlockSize - head - count >= BlockSize)
+			{
+				std::rotate(map.begin(), map.end() - 1, map.end());
+				head += BlockSize;
+				return;
+			}
+			auto n{ std::max<std::size_t>(1, map.size()) };
+			auto blocks{ std::vector<T*>(n) };
+			for (auto& b : blocks) { b = alloc.allocate(BlockSize); }
+			map.insert(map.begin(), blocks.begin(), blocks.end());
+			head += n * BlockSize;
+		}
+
+		std::allocator<T> alloc;
+		std::vector<T*> map;
+		std::size_t head{ 0 };
+		std::size_t count{ 0 };
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Chunked deque demo" << std::endl;
+
+	// The same operations the algorithm demo does with std::deque
+	auto x{ ChunkedDeque<int, 4>() };
+
+	{
+	std::cout << "iterating: ";
+	x = { 1, 2, 3, 4, 5 };
+	for (auto& i : x) { std::cout << i << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "pushing to both ends: ";
+	x = { 1, 2, 3, 4, 5 };
+	x.push_front(0);
+	x.push_back(6);
+	for (auto& i : x) { std::cout << i << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "sorting with ranges: ";
+	x = { 4, 8, 45, 2, 4, 6, 9 };
+	std::ranges::sort(x);
+	for (auto& i : x) { std::cout << i << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "inserting item: ";
+	x = { 1, 2, 3, 4, 5 };
+	auto it = std::ranges::begin(x);
+	x.insert(it + 2, 0);
+	for (auto i : x) { std::cout << i << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "erasing item: ";
+	x = { 1, 2, 3, 4, 5 };
+	auto it = std::ranges::begin(x);
+	x.erase(it + 2);
+	for (auto i : x) { std::cout << i << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "iterating by segments: ";
+	x = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	x.push_front(0);
+	// Each segment is a plain array of at most 4 items here
+	x.for_each_segment(
+		[](std::span<int> s) -> void
+		{
+			std::cout << "[ ";
+			for (auto i : s) { std::cout << i << " "; }
+			std::cout << "] ";
+		});
+	std::cout << std::endl;
+	}
+
+	{
+	// Element count may be passed as the first argument
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	auto edits{ std::size_t{ 200 } };
+	std::cout << std::endl << "Benchmark, " << n << " items, ms"
+		<< std::endl;
+
+	auto rng{ std::mt19937{ 42 } };
+	auto indexes{ std::vector<std::size_t>(n) };
+	for (auto& i : indexes) { i = rng() % n; }
+
+	auto sink{ 0l };
+	auto report{
+		[](const char* name, double push_back, double push_front,
+			double random, double middle, double scan) -> void
+		{
+			std::cout << name
+				<< " push_back: " << push_back
+				<< " push_front: ";
+			if (push_front < 0) { std::cout << "n/a"; }
+			else { std::cout << push_front; }
+			std::cout
+				<< " random access: " << random
+				<< " middle insert/erase: " << middle
+				<< " scan: " << scan << std::endl;
+		}
+	};
+
+	auto bench{
+		[&](auto& c, const char* name) -> void
+		{
+			auto pb{ measure([&]() {
+				for (std::size_t i{ 0 }; i < n; i++)
+				{ c.push_back(int(i)); } }) };
+			auto pf{ -1.0 };
+			if constexpr (requires { c.push_front(0); })
+			{
+				pf = measure([&]() {
+					for (std::size_t i{ 0 }; i < n; i++)
+					{ c.push_front(int(i)); } });
+			}
+			auto ra{ measure([&]() {
+				for (auto i : indexes) { sink += c[i]; } }) };
+			auto mid{ measure([&]() {
+				for (std::size_t i{ 0 }; i < edits; i++)
+				{
+					auto pos{ c.begin() + c.size() / 3 };
+					c.insert(pos, int(i));
+					c.erase(c.begin() + c.size() / 3);
+				} }) };
+			auto sc{ measure([&]() {
+				for (auto v : c) { sink += v; } }) };
+			report(name, pb, pf, ra, mid, sc);
+		}
+	};
+
+	{
+	auto c{ std::deque<int>() };
+	bench(c, "std::deque  ");
+	}
+
+	{
+	auto c{ std::vector<int>() };
+	// push_front is quadratic for a vector, so it's skipped
+	bench(c, "std::vector ");
+	}
+
+	{
+	auto c{ ChunkedDeque<int, 4096>() };
+	bench(c, "ChunkedDeque");
+	auto seg{ measure([&]() {
+		c.for_each_segment(
+			[&](std::span<int> s) -> void
+			{
+				auto sum{ 0l };
+				for (auto v : s) { sum += v; }
+				sink += sum;
+			}); }) };
+	std::cout << "ChunkedDeque segment scan: " << seg << std::endl;
+	}
+
+	std::cout << "checksum: " << sink << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,303 @@
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+// std::optional<int> is an int and a bool, padded to 8 bytes, so a vector
+// of them is twice as big as a vector of ints. There are two ways to get rid
+// of the flag: reserve one value of the type as "no value" (a sentinel), or
+// keep the flags apart from the values, one bit per item.
+
+/** \brief Sentinel tag: floating point NaN means "no value" */
+struct NanSentinel {};
+
+/** \brief Empty value used when none is given: NaN for floats, the minimal
+ *         value for signed integers and the maximal one for unsigned,
+ *         where the minimal value 0 is too common to give up */
+template<typename T>
+constexpr auto default_sentinel()
+{
+	// Both values of bool are needed, the empty one must be chosen
+	static_assert(!std::is_same_v<T, bool>,
+		"bool has no default sentinel, pass it explicitly");
+	if constexpr (std::is_floating_point_v<T>) { return NanSentinel{}; }
+	else if constexpr (std::is_unsigned_v<T>)
+	{
+		return std::numeric_limits<T>::max();
+	}
+	else { return std::numeric_limits<T>::min(); }
+}
+
+/** \brief   Optional without the flag, one value of T means empty
+ *  \details sizeof(CompactOptional<T>) == sizeof(T). The sentinel value
+ *           itself can't be stored, see default_sentinel() for the
+ *           default one. bool needs an explicit sentinel.
+ *  \tparam  Sentinel The empty value or NanSentinel{} */
+template<typename T, auto Sentinel = default_sentinel<T>()>
+class CompactOptional
+{
+	static constexpr bool nan{
+		std::is_same_v<std::remove_cv_t<decltype(Sentinel)>, NanSentinel> };
+
+	static constexpr T empty()
+	{
+		if constexpr (nan) { return std::numeric_limits<T>::quiet_NaN(); }
+		else { return Sentinel; }
+	}
+
+	public:
+		constexpr CompactOptional() = default;
+		constexpr CompactOptional(std::nullopt_t) {}
+		constexpr CompactOptional(T value) : data(value) {}
+
+		constexpr CompactOptional& operator=(std::nullopt_t)
+		{
+			reset();
+			return *this;
+		}
+
+		constexpr bool has_value() const
+		{
+			if constexpr (nan) { return !std::isnan(data); }
+			else { return data != Sentinel; }
+		}
+
+		constexpr explicit operator bool() const { return has_value(); }
+
+		constexpr T value() const
+		{
+			if (!has_value()) { throw std::bad_optional_access(); }
+			return data;
+		}
+
+		constexpr T operator*() const { return data; }
+
+		constexpr T value_or(T alternative) const
+		{
+			return has_value() ? data : alternative;
+		}
+
+		constexpr void reset() { data = empty(); }
+
+	private:
+		T data{ empty() };
+};
+
+static_assert(sizeof(CompactOptional<int>) == sizeof(int));
+static_assert(sizeof(CompactOptional<double>) == sizeof(double));
+
+/** \brief   Vector of optionals with the presence bits stored apart
+ *  \details Values are a plain vector, and one bit per item tells if the
+ *           value is there. Scans skip empty items 64 at a time, and any
+ *           value of T may be stored. */
+template<typename T>
+class OptionalVector
+{
+	public:
+		void reserve(std::size_t n)
+		{
+			values.reserve(n);
+			bits.reserve((n + 63) / 64);
+		}
+
+		void push_back(std::optional<T> v)
+		{
+			if (values.size() % 64 == 0) { bits.push_back(0); }
+			values.push_back(v.value_or(T{}));
+			if (v) { set_bit(values.size() - 1); }
+		}
+
+		std::size_t size() const { return values.size(); }
+
+		bool has_value(std::size_t i) const
+		{
+			return (bits[i / 64] >> (i % 64)) & 1;
+		}
+
+		T value_or(std::size_t i, T alternative) const
+		{
+			return has_value(i) ? values[i] : alternative;
+		}
+
+		std::optional<T> operator[](std::size_t i) const
+		{
+			if (has_value(i)) { return values[i]; }
+			return std::nullopt;
+		}
+
+		void set(std::size_t i, T v)
+		{
+			values[i] = v;
+			set_bit(i);
+		}
+
+		void reset(std::size_t i)
+		{
+			bits[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+		}
+
+		/** \brief Calls f(index, value) for every present value */
+		template<typename F>
+		void for_each_present(F&& f) const
+		{
+			for (std::size_t w{ 0 }; w < bits.size(); w++)
+			{
+				auto word{ bits[w] };
+				while (word)
+				{
+					auto i{ w * 64 + std::countr_zero(word) };
+					f(i, values[i]);
+					word &= word - 1;
+				}
+			}
+		}
+
+		/** \brief Memory used by the items and the bits, in bytes */
+		std::size_t bytes() const
+		{
+			return values.size() * sizeof(T)
+				+ bits.size() * sizeof(std::uint64_t);
+		}
+
+	private:
+		void set_bit(std::size_t i)
+		{
+			bits[i / 64] |= std::uint64_t(1) << (i % 64);
+		}
+
+		std::vector<T> values;
+		std::vector<std::uint64_t> bits;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Compact optional demo" << std::endl;
+
+	{
+	auto x{ CompactOptional<int>{ 1 } };
+	auto y{ CompactOptional<int, -1>{} };
+	auto z{ CompactOptional<double>{ std::nullopt } };
+
+	std::cout << "checking values: "
+		<< "x " << (x ? "has value" : "has no value") << ", "
+		<< "y " << (y ? "has value" : "has no value") << ", "
+		<< "z " << (z ? "has value" : "has no value")
+		<< std::endl;
+
+	y = 10;
+	z = 3.14;
+	std::cout << "extracting values with alternative: "
+		<< "x = " << x.value_or(300) << ", "
+		<< "y = " << y.value_or(300) << ", "
+		<< "z = " << z.value_or(300)
+		<< std::endl;
+
+	std::cout << "returning optional: ";
+	auto lambda = [](bool val) -> CompactOptional<int>
+	{
+		if (val)
+		{
+			return 10;
+		}
+		else
+		{
+			return {};
+		}
+	};
+	std::cout
+		<< lambda(true).value_or(300)
+		<< lambda(false).value_or(300)
+		<< std::endl;
+
+	std::cout << "clearing the optional: ";
+	x.reset();
+	std::cout << "x = " << x.value_or(300) << std::endl;
+
+	std::cout << "sizes: std::optional<int> " << sizeof(std::optional<int>)
+		<< ", CompactOptional<int> " << sizeof(CompactOptional<int>)
+		<< std::endl;
+	}
+
+	{
+	std::cout << "vector with presence bits: ";
+	auto v{ OptionalVector<int>{} };
+	v.push_back(1);
+	v.push_back(std::nullopt);
+	v.push_back(3);
+	v.reset(0);
+	v.set(1, 2);
+	for (std::size_t i{ 0 }; i < v.size(); i++)
+	{
+		std::cout << v.value_or(i, 300) << " ";
+	}
+	std::cout << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n
+		<< " items, a half is empty, ms" << std::endl;
+
+	auto rng{ std::mt19937{ 42 } };
+	auto source{ std::vector<std::optional<int>>(n) };
+	for (auto& i : source)
+	{
+		if (rng() % 2) { i = int(rng() % 1000); }
+	}
+
+	auto compact{ std::vector<CompactOptional<int>>{} };
+	auto bitmap{ OptionalVector<int>{} };
+	compact.reserve(n);
+	bitmap.reserve(n);
+	for (auto& i : source)
+	{
+		compact.push_back(i ? CompactOptional<int>(*i) : std::nullopt);
+		bitmap.push_back(i);
+	}
+
+	auto a{ 0l }, b{ 0l }, c{ 0l }, d{ 0l };
+	auto std_ms{ measure([&]() {
+		for (auto& i : source) { a += i.value_or(0); } }) };
+	auto compact_ms{ measure([&]() {
+		for (auto& i : compact) { b += i.value_or(0); } }) };
+	auto bitmap_ms{ measure([&]() {
+		for (std::size_t i{ 0 }; i < n; i++)
+		{
+			c += bitmap.value_or(i, 0);
+		} }) };
+	auto present_ms{ measure([&]() {
+		bitmap.for_each_present(
+			[&](std::size_t, int v) { d += v; }); }) };
+
+	std::cout << "std::vector<std::optional<int>>: " << std_ms
+		<< " (" << n * sizeof(std::optional<int>) << " bytes)"
+		<< std::endl;
+	std::cout << "std::vector<CompactOptional<int>>: " << compact_ms
+		<< " (" << n * sizeof(CompactOptional<int>) << " bytes)"
+		<< std::endl;
+	std::cout << "OptionalVector<int> value_or: " << bitmap_ms
+		<< " (" << bitmap.bytes() << " bytes)" << std::endl;
+	std::cout << "OptionalVector<int> for_each_present: " << present_ms
+		<< std::endl;
+	std::cout << (a == b && b == c && c == d ? "sums match" : "SUMS DIFFER")
+		<< std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,235 @@
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <ranges>
+#include <algorithm>
+
+// std::ranges::remove and std::ranges::remove_if only move the kept items to
+// the front of the range, the container size stays the same and the tail
+// holds moved-from garbage. The functions below do the whole job in a single
+// pass: they compact the items and shrink the container. None of them
+// allocate. They work with any container that has random access iterators
+// and pop_back, like std::vector or std::deque.
+
+/** \brief Drops the items from position n to the end of the container */
+template<typename C>
+void truncate(C& c, std::size_t n)
+{
+	if constexpr (requires { c.erase(c.begin(), c.end()); })
+	{
+		c.erase(c.begin() + n, c.end());
+	}
+	else
+	{
+		while (c.size() > n) { c.pop_back(); }
+	}
+}
+
+/** \brief   Removes the items matching pred keeping the order of the rest
+ *  \details Every kept item is moved at most once
+ *  \return  Number of removed items */
+template<typename C, typename Pred>
+std::size_t erase_if_stable(C& c, Pred pred)
+{
+	auto first{ c.begin() };
+	auto last{ c.end() };
+	// Nothing to move before the first matching item
+	while (first != last && !pred(*first)) { ++first; }
+
+	auto out{ first };
+	for (; first != last; ++first)
+	{
+		if (!pred(*first)) { *out++ = std::move(*first); }
+	}
+
+	auto kept{ static_cast<std::size_t>(out - c.begin()) };
+	auto removed{ c.size() - kept };
+	truncate(c, kept);
+	return removed;
+}
+
+/** \brief   Removes the items matching pred, the order is not preserved
+ *  \details Holes at the front are filled with the kept items from the
+ *           back, so only the items that should be kept and sit behind
+ *           the new end are moved
+ *  \return  Number of removed items */
+template<typename C, typename Pred>
+std::size_t erase_if_unstable(C& c, Pred pred)
+{
+	auto first{ c.begin() };
+	auto last{ c.end() };
+	while (true)
+	{
+		while (first != last && !pred(*first)) { ++first; }
+		if (first == last) { break; }
+		--last;
+		while (first != last && pred(*last)) { --last; }
+		if (first == last) { break; }
+		*first = std::move(*last);
+		++first;
+	}
+
+	auto kept{ static_cast<std::size_t>(first - c.begin()) };
+	auto removed{ c.size() - kept };
+	truncate(c, kept);
+	return removed;
+}
+
+/** \brief   Removes the item at index i by moving the last item in its
+ *           place
+ *  \details Constant time, the order is not preserved */
+template<typename C>
+void erase_unstable(C& c, std::size_t i)
+{
+	if (i + 1 != c.size()) { c[i] = std::move(c.back()); }
+	c.pop_back();
+}
+
+/** \brief   Removes the items at the given indexes keeping the order of
+ *           the rest
+ *  \details indexes should be sorted ascending and unique. Kept items
+ *           between two removed ones are moved as one block.
+ *  \return  Number of removed items */
+template<typename C, typename Indexes>
+std::size_t erase_indices(C& c, const Indexes& indexes)
+{
+	auto first{ std::ranges::begin(indexes) };
+	auto last{ std::ranges::end(indexes) };
+	if (first == last) { return 0; }
+
+	auto out{ c.begin() + *first };
+	while (first != last)
+	{
+		auto from{ *first + 1 };
+		++first;
+		auto to{ first == last ? c.size() : *first };
+		out = std::move(c.begin() + from, c.begin() + to, out);
+	}
+
+	auto kept{ static_cast<std::size_t>(out - c.begin()) };
+	auto removed{ c.size() - kept };
+	truncate(c, kept);
+	return removed;
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Compaction demo" << std::endl;
+
+	auto x{ std::deque<int>() };
+
+	{
+	std::cout << "remove items keeping order: " << std::endl;
+	// unlike std::ranges::remove the size of deque is changed
+	x = { 1, 2, 3, 4, 5 };
+	for (auto i : x) { std::cout << i << " "; } std::cout << std::endl;
+	erase_if_stable(x, [](auto& v) -> bool { return v == 2; });
+	for (auto i : x) { std::cout << i << " "; } std::cout << std::endl;
+	}
+
+	{
+	std::cout << "remove by criteria without keeping order: " << std::endl;
+	x = { 1, 2, 3, 4, 5 };
+	for (auto i : x) { std::cout << i << " "; } std::cout << std::endl;
+	erase_if_unstable(x, [](auto& v) -> bool { return v % 2 == 0; });
+	for (auto i : x) { std::cout << i << " "; } std::cout << std::endl;
+	}
+
+	{
+	std::cout << "remove single item swapping with the last: " << std::endl;
+	x = { 1, 2, 3, 4, 5 };
+	for (auto i : x) { std::cout << i << " "; } std::cout << std::endl;
+	erase_unstable(x, 1);
+	for (auto i : x) { std::cout << i << " "; } std::cout << std::endl;
+	}
+
+	{
+	std::cout << "remove items by indexes: " << std::endl;
+	auto y{ std::vector<std::string>{ "a", "b", "c", "d", "e", "f" } };
+	for (auto& i : y) { std::cout << i << " "; } std::cout << std::endl;
+	erase_indices(y, std::vector<std::size_t>{ 0, 2, 3 });
+	for (auto& i : y) { std::cout << i << " "; } std::cout << std::endl;
+	}
+
+	{
+	// Element count may be passed as the first argument
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n << " items, ms"
+		<< std::endl;
+
+	auto rng{ std::mt19937{ 42 } };
+	auto source{ std::vector<int>(n) };
+	for (auto& i : source) { i = rng() % 100; }
+	auto sink{ 0ul };
+
+	for (auto percent : { 1, 10, 50, 90 })
+	{
+		auto pred{ [=](int v) -> bool { return v < percent; } };
+		auto c{ source };
+
+		auto idiom{ measure([&]() {
+			c.erase(std::remove_if(c.begin(), c.end(), pred),
+				c.end()); }) };
+		sink += c.size();
+
+		c = source;
+		auto stable{ measure([&]() { erase_if_stable(c, pred); }) };
+		sink += c.size();
+
+		c = source;
+		auto unstable{ measure([&]() { erase_if_unstable(c, pred); }) };
+		sink += c.size();
+
+		std::cout << percent << "% removed,"
+			<< " remove_if+erase: " << idiom
+			<< " erase_if_stable: " << stable
+			<< " erase_if_unstable: " << unstable << std::endl;
+	}
+
+	{
+	auto k{ std::min<std::size_t>(n, 1000) };
+	auto indexes{ std::vector<std::size_t>(k) };
+	for (auto& i : indexes) { i = rng() % n; }
+	std::ranges::sort(indexes);
+	auto dup{ std::ranges::unique(indexes) };
+	indexes.erase(dup.begin(), dup.end());
+
+	auto c{ source };
+	auto one_by_one{ measure([&]() {
+		for (auto i : indexes | std::views::reverse)
+		{ c.erase(c.begin() + i); } }) };
+	sink += c.size();
+
+	c = source;
+	auto batch{ measure([&]() { erase_indices(c, indexes); }) };
+	sink += c.size();
+
+	c = source;
+	auto swapping{ measure([&]() {
+		for (auto i : indexes | std::views::reverse)
+		{ erase_unstable(c, i); } }) };
+	sink += c.size();
+
+	std::cout << indexes.size() << " indexes,"
+		<< " erase one by one: " << one_by_one
+		<< " erase_indices: " << batch
+		<< " erase_unstable: " << swapping << std::endl;
+	}
+
+	std::cout << "checksum: " << sink << std::endl;
+	}
+
+	return 0;
+}
@@ -11,6 +11,7 @@
 #include <optional>
 #include <any>
 #include <variant>
+#include "type_name.h"
 
 int main(int argc, char** argv)
 {
@@ -547,16 +548,22 @@ int main(int argc, char** argv)
 		// It may change it's type whan assigning new value.
 		auto x{ std::make_any<int>(1) };
 
-		std::cout << "extracting value from any: "
-			<< x.type().name() << " x = "
-			<< std::any_cast<int>(x)
-			<< std::endl;
+		// Without RTTI the held type can't be named, but any_cast of
+		// a pointer checks it: it returns nullptr for the other types
+		auto holds{ [&]() {
+			std::cout << "holds " << type_name<int>() << ": "
+				<< (std::any_cast<int>(&x) != nullptr) << ", holds "
+				<< type_name<double>() << ": "
+				<< (std::any_cast<double>(&x) != nullptr); } };
+
+		std::cout << "extracting value from any: ";
+		holds();
+		std::cout << ", x = " << std::any_cast<int>(x) << std::endl;
 
 		std::cout << "assigning value to any: ";
 		x = 3.14;
-		std::cout << x.type().name() << " x = "
-			<< std::any_cast<double>(x)
-			<< std::endl;
+		holds();
+		std::cout << ", x = " << std::any_cast<double>(x) << std::endl;
 	}
 
 	{
@@ -0,0 +1,245 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+template<typename Sig> class Delegate;
+
+/** \brief   Non-owning callable of two words
+ *  \details Holds a pointer to the object (or to the function) and a
+ *           pointer to the thunk, a tiny function generated at compile time
+ *           for each bound target. Calling the delegate is one indirect
+ *           call. Nothing is allocated or copied, the delegate is trivially
+ *           copyable, but the bound object should outlive the delegate. */
+template<typename R, typename... Args>
+class Delegate<R(Args...)>
+{
+	using Thunk = R (*)(const Delegate&, Args...);
+
+	public:
+		Delegate() = default;
+
+		/** \brief   Binds the stateless lambda or functor
+		 *  \details Nothing is stored: the thunk makes a new empty
+		 *           object on the call. Lambdas with captures should be
+		 *           bound with bind_object. */
+		template<typename F>
+			requires std::is_empty_v<F>
+				&& std::is_default_constructible_v<F>
+				&& std::is_invocable_r_v<R, F&, Args...>
+		Delegate(F)
+		{
+			thunk = [](const Delegate&, Args... args) -> R
+			{
+				auto f{ F{} };
+				return f(std::forward<Args>(args)...);
+			};
+		}
+
+		/** \brief Binds the function pointer known at runtime */
+		Delegate(R (*func)(Args...))
+		{
+			target.func = func;
+			thunk = [](const Delegate& d, Args... args) -> R
+			{
+				return d.target.func(std::forward<Args>(args)...);
+			};
+		}
+
+		/** \brief Binds the free or static function at compile time */
+		template<auto Func>
+		static Delegate bind()
+		{
+			auto d{ Delegate{} };
+			d.thunk = [](const Delegate&, Args... args) -> R
+			{
+				return std::invoke(Func, std::forward<Args>(args)...);
+			};
+			return d;
+		}
+
+		/** \brief Binds the member function to the object */
+		template<auto Method, typename C>
+		static Delegate bind(C* obj)
+		{
+			auto d{ Delegate{} };
+			// const is dropped to keep one pointer type, the thunk
+			// restores it
+			d.target.obj = const_cast<void*>(
+				static_cast<const void*>(obj));
+			d.thunk = [](const Delegate& d, Args... args) -> R
+			{
+				return std::invoke(Method, static_cast<C*>(d.target.obj),
+					std::forward<Args>(args)...);
+			};
+			return d;
+		}
+
+		/** \brief Binds the call operator of the object (functor, lambda) */
+		template<typename C>
+		static Delegate bind_object(C* obj)
+		{
+			auto d{ Delegate{} };
+			d.target.obj = const_cast<void*>(
+				static_cast<const void*>(obj));
+			d.thunk = [](const Delegate& d, Args... args) -> R
+			{
+				return std::invoke(*static_cast<C*>(d.target.obj),
+					std::forward<Args>(args)...);
+			};
+			return d;
+		}
+
+		R operator()(Args... args) const
+		{
+			return thunk(*this, std::forward<Args>(args)...);
+		}
+
+		explicit operator bool() const { return thunk != nullptr; }
+
+		friend bool operator==(const Delegate& a, const Delegate& b)
+		{
+			return a.thunk == b.thunk
+				&& std::bit_cast<std::uintptr_t>(a.target)
+				== std::bit_cast<std::uintptr_t>(b.target);
+		}
+
+	private:
+		union Target
+		{
+			void* obj{ nullptr };
+			R (*func)(Args...);
+		} target;
+		Thunk thunk{ nullptr };
+};
+
+static_assert(sizeof(Delegate<void()>) == 2 * sizeof(void*));
+static_assert(std::is_trivially_copyable_v<Delegate<void()>>);
+
+class Dummy
+{
+	public:
+		void do_something()
+		{
+			std::cout << "Dummy doing something" << std::endl;
+		}
+
+		static void do_something_static()
+		{
+			std::cout << "Dummy doing something statically"
+				<< std::endl;
+		}
+
+		int add(int v) { total += v; return total; }
+
+		int total{ 0 };
+};
+
+class DummyFunctor
+{
+	public:
+		void operator()()
+		{
+			std::cout << "DummyFunctor doing something"
+				<< std::endl;
+		}
+};
+
+void do_something()
+{
+	std::cout << "Doing domething globally" << std::endl;
+}
+
+// Not inlined, so the compiler can't see which target is behind the callable
+template<typename F>
+[[gnu::noinline]] long call_many(F f, long n)
+{
+	auto sum{ 0l };
+	for (long i{ 0 }; i < n; i++) { sum += f(1); }
+	return sum;
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Delegate demo" << std::endl;
+
+	{
+	auto x{ Delegate<void(void)>{ do_something } };
+	auto y{ Delegate<void(void)>() };
+
+	std::cout << "checking if the object is available: "
+		<< (y ? "y is set" : "y is not set") << std::endl;
+
+	std::cout << "function callback: ";
+	x();
+
+	std::cout << "function bound at compile time: ";
+	x = Delegate<void(void)>::bind<do_something>();
+	x();
+
+	std::cout << "static member function callback: ";
+	x = Dummy::do_something_static;
+	x();
+
+	std::cout << "member function callback: ";
+	auto dummy{ Dummy() };
+	// Unlike std::bind, only the pointer to dummy is stored
+	x = Delegate<void(void)>::bind<&Dummy::do_something>(&dummy);
+	x();
+
+	std::cout << "functor callback: ";
+	auto functor{ DummyFunctor() };
+	x = Delegate<void(void)>::bind_object(&functor);
+	x();
+
+	std::cout << "lambda function callback: ";
+	x = []() -> void {
+		std::cout << "Doing something from lambda" << std::endl;
+	};
+	x();
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	std::cout << std::endl << "Benchmark, " << n << " calls" << std::endl;
+
+	auto dummy{ Dummy() };
+	auto lambda{ [&dummy](int v) { return dummy.add(v); } };
+	auto bound{ std::bind(&Dummy::add, dummy, std::placeholders::_1) };
+	auto function{ std::function<int(int)>(bound) };
+	auto function_lambda{ std::function<int(int)>(lambda) };
+	auto delegate{ Delegate<int(int)>::bind<&Dummy::add>(&dummy) };
+	auto sink{ 0l };
+
+	auto row{
+		[&](const char* name, std::size_t size, const auto& f) -> void
+		{
+			auto ms{ measure([&]() { sink += call_many(f, n); }) };
+			std::cout << name << " size: " << size
+				<< " ns per call: " << ms * 1e6 / n << std::endl;
+		}
+	};
+
+	row("lambda                  ", sizeof(lambda), lambda);
+	row("std::bind               ", sizeof(bound), bound);
+	row("std::function(std::bind)", sizeof(function), function);
+	row("std::function(lambda)   ", sizeof(function_lambda),
+		function_lambda);
+	row("Delegate                ", sizeof(delegate), delegate);
+	std::cout << "checksum: " << sink << std::endl;
+	}
+
+	return 0;
+}
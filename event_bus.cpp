@@ -0,0 +1,293 @@
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+// A callback stored in std::function is a pointer to a heap allocated object
+// as soon as the callable is bigger than a couple of pointers, and a list of
+// them is a list of pointers to scattered memory. The signal below stores
+// every slot right in the vector: a small buffer with the callable and a
+// pointer to the function that knows how to call it.
+
+template<typename Sig> class Signal;
+
+/** \brief   List of slots called together on emit
+ *  \details The slot list is immutable: connect and disconnect make a new
+ *           copy under the mutex and publish it atomically (copy-on-write).
+ *           emit just takes the current list without the mutex, so it
+ *           isn't held up while connect copies the list, and a slot may
+ *           connect or disconnect during the emit safely. The load isn't
+ *           lock-free though: libstdc++'s std::atomic<std::shared_ptr>
+ *           guards the pointer with a short internal spin lock. */
+template<typename... Args>
+class Signal<void(Args...)>
+{
+	static constexpr std::size_t capacity{ 4 * sizeof(void*) };
+
+	struct Slot
+	{
+		alignas(std::max_align_t) std::byte storage[capacity];
+		void (*call)(const std::byte*, Args...);
+		std::uint64_t id;
+	};
+
+	using List = std::vector<Slot>;
+
+	public:
+		using Connection = std::uint64_t;
+
+		Signal() : slots(std::make_shared<const List>()) {}
+
+		/** \brief   Connects any callable
+		 *  \details The callable is copied into the slot, so it should be
+		 *           trivially copyable and small: free functions,
+		 *           lambdas capturing a few pointers or values. */
+		template<typename F>
+		Connection connect(F func)
+		{
+			static_assert(sizeof(F) <= capacity,
+				"the callable is too big for the slot");
+			static_assert(std::is_trivially_copyable_v<F>,
+				"the callable should be trivially copyable");
+
+			auto slot{ Slot{} };
+			std::memcpy(slot.storage, &func, sizeof(F));
+			slot.call = [](const std::byte* p, Args... args) -> void
+			{
+				auto& f{ *std::launder(reinterpret_cast<const F*>(p)) };
+				std::invoke(f, std::forward<Args>(args)...);
+			};
+			return add(slot);
+		}
+
+		/** \brief   Connects the member function bound to the object
+		 *  \details The function is a template parameter, so the call is
+		 *           resolved at compile time and only the object pointer
+		 *           is stored. No std::bind, no copy of the object. */
+		template<auto Method, typename C>
+		Connection connect(C* obj)
+		{
+			auto slot{ Slot{} };
+			std::memcpy(slot.storage, &obj, sizeof(obj));
+			slot.call = [](const std::byte* p, Args... args) -> void
+			{
+				C* obj{ nullptr };
+				std::memcpy(&obj, p, sizeof(obj));
+				(obj->*Method)(std::forward<Args>(args)...);
+			};
+			return add(slot);
+		}
+
+		/** \brief Disconnects the slot, unknown connections are ignored */
+		void disconnect(Connection id)
+		{
+			auto lock{ std::lock_guard(m) };
+			auto list{ List(*slots.load()) };
+			std::erase_if(list, [=](auto& s) { return s.id == id; });
+			slots.store(std::make_shared<const List>(std::move(list)));
+		}
+
+		/** \brief Calls all of the connected slots in connection order */
+		void emit(Args... args) const
+		{
+			auto list{ slots.load() };
+			for (auto& s : *list) { s.call(s.storage, args...); }
+		}
+
+		void operator()(Args... args) const { emit(args...); }
+
+		std::size_t size() const { return slots.load()->size(); }
+
+	private:
+		Connection add(Slot slot)
+		{
+			auto lock{ std::lock_guard(m) };
+			slot.id = ++last_id;
+			auto list{ List(*slots.load()) };
+			list.push_back(slot);
+			slots.store(std::make_shared<const List>(std::move(list)));
+			return slot.id;
+		}
+
+		std::atomic<std::shared_ptr<const List>> slots;
+		std::mutex m;
+		std::uint64_t last_id{ 0 };
+};
+
+/** \brief   Event bus with the list of event types known at compile time
+ *  \details Every event type has its own signal, and publish picks it by
+ *           the type at compile time: no maps, no type ids, no casts. */
+template<typename... Events>
+class EventBus
+{
+	public:
+		template<typename E, typename F>
+		auto subscribe(F func) { return signal<E>().connect(func); }
+
+		template<typename E, auto Method, typename C>
+		auto subscribe(C* obj)
+		{
+			return signal<E>().template connect<Method>(obj);
+		}
+
+		template<typename E>
+		void unsubscribe(typename Signal<void(const E&)>::Connection id)
+		{
+			signal<E>().disconnect(id);
+		}
+
+		template<typename E>
+		void publish(const E& event) const
+		{
+			std::get<Signal<void(const E&)>>(signals).emit(event);
+		}
+
+	private:
+		template<typename E>
+		Signal<void(const E&)>& signal()
+		{
+			return std::get<Signal<void(const E&)>>(signals);
+		}
+
+		std::tuple<Signal<void(const Events&)>...> signals;
+};
+
+struct Started { std::string name; };
+struct Progress { int percent; };
+
+class Dummy
+{
+	public:
+		void on_started(const Started& e)
+		{
+			std::cout << "Dummy sees " << e.name << " started"
+				<< std::endl;
+		}
+
+		void on_progress(const Progress& e) { total += e.percent; }
+
+		void on_value(int v) { total += v; }
+
+		int total{ 0 };
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Event bus demo" << std::endl;
+
+	{
+	std::cout << "signal with a few slots: " << std::endl;
+	auto s{ Signal<void(int)>{} };
+	auto a{ s.connect([](int v) { std::cout << "lambda got " << v
+		<< std::endl; }) };
+	auto dummy{ Dummy{} };
+	s.connect<&Dummy::on_value>(&dummy);
+	s.emit(10);
+	s(20);
+	std::cout << "dummy total: " << dummy.total << std::endl;
+
+	std::cout << "disconnecting the lambda: " << std::endl;
+	s.disconnect(a);
+	s.emit(30);
+	std::cout << "dummy total: " << dummy.total << std::endl;
+	}
+
+	{
+	std::cout << "event bus: " << std::endl;
+	auto bus{ EventBus<Started, Progress>{} };
+	auto dummy{ Dummy{} };
+	bus.subscribe<Started, &Dummy::on_started>(&dummy);
+	bus.subscribe<Progress, &Dummy::on_progress>(&dummy);
+	bus.subscribe<Progress>([](const Progress& p) {
+		std::cout << "progress " << p.percent << "%" << std::endl; });
+
+	bus.publish(Started{ "download" });
+	bus.publish(Progress{ 50 });
+	bus.publish(Progress{ 100 });
+	std::cout << "dummy total: " << dummy.total << std::endl;
+	}
+
+	{
+	std::cout << "connecting while the other thread emits: ";
+	auto s{ Signal<void(int)>{} };
+	auto sum{ std::atomic<long>{ 0 } };
+	auto running{ std::atomic<bool>{ true } };
+	auto t{ std::thread{ [&]() {
+		while (running) { s.emit(1); } } } };
+	auto ids{ std::vector<Signal<void(int)>::Connection>{} };
+	for (int i{ 0 }; i < 100; i++)
+	{
+		ids.push_back(s.connect([&sum](int v) { sum += v; }));
+	}
+	for (auto id : ids) { s.disconnect(id); }
+	running = false;
+	t.join();
+	std::cout << s.size() << " slots left" << std::endl;
+	}
+
+	{
+	auto emits{ argc > 1 ? std::stoul(argv[1]) : 100'000ul };
+	std::cout << std::endl << "Benchmark, " << emits
+		<< " emits, ns per emit" << std::endl;
+
+	for (auto subscribers : { 1, 10, 100, 1000 })
+	{
+		auto counter{ 0l };
+		auto dummies{ std::vector<Dummy>(subscribers) };
+		auto n{ emits / subscribers + 1 };
+
+		auto functions{ std::vector<std::function<void(int)>>{} };
+		auto s{ Signal<void(int)>{} };
+		for (int i{ 0 }; i < subscribers; i++)
+		{
+			// Half of the subscribers are lambdas, half are members
+			if (i % 2 == 0)
+			{
+				functions.push_back(
+					[&counter](int v) { counter += v; });
+				s.connect([&counter](int v) { counter += v; });
+			}
+			else
+			{
+				functions.push_back(std::bind(&Dummy::on_value,
+					&dummies[i], std::placeholders::_1));
+				s.connect<&Dummy::on_value>(&dummies[i]);
+			}
+		}
+
+		auto std_ms{ measure([&]() {
+			for (std::size_t i{ 0 }; i < n; i++)
+			{
+				for (auto& f : functions) { f(1); }
+			} }) };
+		auto signal_ms{ measure([&]() {
+			for (std::size_t i{ 0 }; i < n; i++) { s.emit(1); } }) };
+
+		std::cout << subscribers << " subscribers,"
+			<< " std::vector<std::function>: " << std_ms * 1e6 / n
+			<< " Signal: " << signal_ms * 1e6 / n << std::endl;
+	}
+	}
+
+	return 0;
+}
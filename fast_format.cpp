@@ -0,0 +1,329 @@
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <type_traits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+// The fold over std::cout << formats every argument through the stream:
+// sentry, locale facets, virtual calls into the stream buffer, and the
+// std::endl after every line is a flush, a write syscall. Here the format
+// string is checked by the compiler, numbers are converted with
+// std::to_chars, and the whole call is collected in a buffer on the stack
+// and written with one syscall.
+
+namespace fast
+{
+	/** \brief   Output buffer on the stack, written to fd with one syscall
+	 *  \details The buffer is written when it's destroyed or full, so only
+	 *           output longer than Size takes more than one write. */
+	template<std::size_t Size = 4096>
+	class Buffer
+	{
+		public:
+			explicit Buffer(int fd) : fd(fd) {}
+			Buffer(const Buffer&) = delete;
+			Buffer& operator=(const Buffer&) = delete;
+			~Buffer() { flush(); }
+
+			void append(std::string_view s)
+			{
+				if (s.size() > Size - used)
+				{
+					flush();
+					if (s.size() > Size)
+					{
+						write_all(s.data(), s.size());
+						return;
+					}
+				}
+				std::memcpy(data + used, s.data(), s.size());
+				used += s.size();
+			}
+
+			void append(char c)
+			{
+				if (used == Size) { flush(); }
+				data[used++] = c;
+			}
+
+			/** \brief Space for n characters, commit with advance */
+			char* reserve(std::size_t n)
+			{
+				if (n > Size - used) { flush(); }
+				return data + used;
+			}
+
+			void advance(std::size_t n) { used += n; }
+
+			void flush()
+			{
+				write_all(data, used);
+				used = 0;
+			}
+
+		private:
+			void write_all(const char* p, std::size_t n)
+			{
+				while (n > 0)
+				{
+					auto written{ ::write(fd, p, n) };
+					if (written <= 0) { return; }
+					p += written;
+					n -= written;
+				}
+			}
+
+			int fd;
+			std::size_t used{ 0 };
+			char data[Size];
+	};
+
+	/** \brief   Writes one argument into the buffer
+	 *  \details Integers and floats go through std::to_chars. Floats use the
+	 *           shortest representation that reads back to the same value,
+	 *           not the 6 digits of iostreams. bool is printed as 1 or 0 like
+	 *           std::cout does. */
+	template<std::size_t S, typename T>
+	void write_arg(Buffer<S>& out, const T& value)
+	{
+		if constexpr (std::is_same_v<T, char>)
+		{
+			out.append(value);
+		}
+		else if constexpr (std::is_same_v<T, bool>)
+		{
+			out.append(value ? '1' : '0');
+		}
+		else if constexpr (std::is_arithmetic_v<T>)
+		{
+			// Enough for any integer and the shortest double
+			constexpr std::size_t max{ 32 };
+			auto p{ out.reserve(max) };
+			auto r{ std::to_chars(p, p + max, value) };
+			out.advance(r.ptr - p);
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+		{
+			out.append(std::string_view(value));
+		}
+		else
+		{
+			static_assert(!sizeof(T), "no formatter for the type");
+		}
+	}
+
+	/** \brief   Format string checked at compile time
+	 *  \details "{}" is replaced by the next argument, "{{" and "}}" are the
+	 *           braces. The constructor is consteval: a wrong number of
+	 *           placeholders or a stray brace is a compile error. The
+	 *           positions of the placeholders are kept, so the runtime only
+	 *           copies the pieces between them. */
+	template<typename... Args>
+	class FormatString
+	{
+		public:
+			template<typename S>
+				requires std::is_convertible_v<const S&, std::string_view>
+			consteval FormatString(const S& s) : text(s)
+			{
+				std::size_t count{ 0 };
+				for (std::size_t i{ 0 }; i < text.size(); i++)
+				{
+					if (text[i] == '{' && i + 1 < text.size()
+						&& text[i + 1] == '{')
+					{
+						escapes = true;
+						i++;
+					}
+					else if (text[i] == '}' && i + 1 < text.size()
+						&& text[i + 1] == '}')
+					{
+						escapes = true;
+						i++;
+					}
+					else if (text[i] == '{' && i + 1 < text.size()
+						&& text[i + 1] == '}')
+					{
+						if (count == sizeof...(Args))
+						{
+							throw std::invalid_argument(
+								"more placeholders than arguments");
+						}
+						positions[count++] = i;
+						i++;
+					}
+					else if (text[i] == '{' || text[i] == '}')
+					{
+						throw std::invalid_argument("unmatched brace");
+					}
+				}
+				if (count != sizeof...(Args))
+				{
+					throw std::invalid_argument(
+						"fewer placeholders than arguments");
+				}
+			}
+
+			std::string_view text;
+			std::array<std::size_t, sizeof...(Args)> positions{};
+			bool escapes{ false };
+	};
+
+	namespace detail
+	{
+		template<std::size_t S>
+		void write_text(Buffer<S>& out, std::string_view s, bool escapes)
+		{
+			if (!escapes) { out.append(s); return; }
+			for (std::size_t i{ 0 }; i < s.size(); i++)
+			{
+				out.append(s[i]);
+				if (s[i] == '{' || s[i] == '}') { i++; }
+			}
+		}
+	}
+
+	template<std::size_t S, typename... Args>
+	void format_to(Buffer<S>& out,
+		FormatString<std::type_identity_t<Args>...> fmt, const Args&... args)
+	{
+		std::size_t from{ 0 }, i{ 0 };
+		auto next{
+			[&](const auto& arg)
+			{
+				auto at{ fmt.positions[i++] };
+				detail::write_text(out, fmt.text.substr(from, at - from),
+					fmt.escapes);
+				write_arg(out, arg);
+				from = at + 2;
+			}
+		};
+		(next(args), ...);
+		detail::write_text(out, fmt.text.substr(from), fmt.escapes);
+	}
+
+	/** \brief Formats to the file descriptor with one write */
+	template<typename... Args>
+	void print(int fd, FormatString<std::type_identity_t<Args>...> fmt,
+		const Args&... args)
+	{
+		auto out{ Buffer<>{ fd } };
+		format_to(out, fmt, args...);
+	}
+
+	template<typename... Args>
+	void print(FormatString<std::type_identity_t<Args>...> fmt,
+		const Args&... args)
+	{
+		print<Args...>(STDOUT_FILENO, fmt, args...);
+	}
+
+	/** \brief Prints all the arguments and the newline, like the fold over
+	 *         std::cout <<, with one write */
+	template<typename... Args>
+	void print_all(int fd, const Args&... args)
+	{
+		auto out{ Buffer<>{ fd } };
+		(write_arg(out, args), ...);
+		out.append('\n');
+	}
+
+	template<typename... Args>
+	void print_all(const Args&... args)
+	{
+		print_all(STDOUT_FILENO, args...);
+	}
+
+	/** \brief Prints "index: argument" lines and the total, with one write */
+	template<typename... Args>
+	void print_enumerated(int fd, const Args&... args)
+	{
+		auto out{ Buffer<>{ fd } };
+		int index{ 0 };
+		((format_to(out, "{}: {}\n", index++, args)), ...);
+		format_to(out, "Total: {}\n", sizeof...(args));
+	}
+
+	template<typename... Args>
+	void print_enumerated(const Args&... args)
+	{
+		print_enumerated(STDOUT_FILENO, args...);
+	}
+}
+
+// Fold expressions from templates.cpp, the stream is a parameter here
+template<typename... Args>
+void print_all(std::ostream& os, Args... args)
+{
+	(os << ... << args) << std::endl;
+}
+
+template<typename... Args>
+void print_enumerated(std::ostream& os, Args&&... args)
+{
+	int index = 0;
+	((os << index++ << ": " << args << std::endl), ...);
+	os << "Total: " << sizeof...(args) << std::endl;
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Compile-time checked formatting demo" << std::endl;
+
+	{
+	fast::print_all("This line ", "is made from ", 4, " parameters!");
+	fast::print_enumerated("foo", "bar", 3.14, 42);
+	fast::print("{} + {} = {}, braces: {{}}\n", 1, 2.5, 3.5);
+	// Compile errors:
+	// fast::print("{} {}\n", 1);
+	// fast::print("{\n", 1);
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 100'000l };
+	std::cout << std::endl << "Benchmark, " << n
+		<< " print_enumerated calls to /dev/null" << std::endl;
+
+	// Both write to /dev/null, so it's the cost of formatting and syscalls
+	auto stream{ std::ofstream("/dev/null") };
+	auto fd{ ::open("/dev/null", O_WRONLY) };
+	if (fd < 0) { std::cout << "can't open /dev/null" << std::endl; return 1; }
+
+	// Every call is 5 lines
+	auto lines{ 5.0 * n };
+	auto stream_ms{ measure([&]() {
+		for (long i{ 0 }; i < n; i++)
+		{
+			print_enumerated(stream, "foo", i, 3.14, 42);
+		} }) };
+	auto fast_ms{ measure([&]() {
+		for (long i{ 0 }; i < n; i++)
+		{
+			fast::print_enumerated(fd, "foo", i, 3.14, 42);
+		} }) };
+	::close(fd);
+
+	std::cout << "iostream fold: " << stream_ms << " ms, "
+		<< lines / stream_ms * 1000 << " lines/s" << std::endl;
+	std::cout << "fast::print_enumerated: " << fast_ms << " ms, "
+		<< lines / fast_ms * 1000 << " lines/s" << std::endl;
+	}
+
+	return 0;
+}
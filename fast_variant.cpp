@@ -0,0 +1,284 @@
+#include <iostream>
+#include <vector>
+#include <variant>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+// std::visit goes through a table of function pointers, one per
+// alternative. An indirect call can't be inlined, so even visiting
+// variant<int, bool> with a trivial lambda becomes a real call. A switch on
+// the index is turned into a jump table by the compiler as well, but every
+// case is a direct call that may be inlined.
+
+namespace fast
+{
+	/** \brief   Visits the std::variant by switching on the index
+	 *  \details Alternatives are handled 8 per switch, the default case
+	 *           goes to the next 8, so any number of alternatives works,
+	 *           and small variants are a single switch. */
+	template<std::size_t Base = 0, typename F, typename V>
+	decltype(auto) visit(F&& f, V&& v)
+	{
+		constexpr auto size{ std::variant_size_v<std::remove_cvref_t<V>> };
+		auto call{
+			[&]<std::size_t I>() -> decltype(auto)
+			{
+				if constexpr (I < size)
+				{
+					return std::invoke(std::forward<F>(f),
+						*std::get_if<I>(&v));
+				}
+				else
+				{
+					// Never called, only keeps the return type
+					return std::invoke(std::forward<F>(f),
+						*std::get_if<0>(&v));
+				}
+			}
+		};
+
+		switch (v.index() - Base)
+		{
+			case 0: return call.template operator()<Base + 0>();
+			case 1: return call.template operator()<Base + 1>();
+			case 2: return call.template operator()<Base + 2>();
+			case 3: return call.template operator()<Base + 3>();
+			case 4: return call.template operator()<Base + 4>();
+			case 5: return call.template operator()<Base + 5>();
+			case 6: return call.template operator()<Base + 6>();
+			case 7: return call.template operator()<Base + 7>();
+			default:
+				if constexpr (Base + 8 < size)
+				{
+					return visit<Base + 8>(std::forward<F>(f),
+						std::forward<V>(v));
+				}
+				else
+				{
+					// valueless_by_exception or a broken index
+					throw std::bad_variant_access();
+				}
+		}
+	}
+}
+
+/** \brief   Variant of trivially copyable types with the packed layout
+ *  \details std::variant aligns the index like the largest alternative,
+ *           so variant<int, bool> takes 8 bytes and variant<double, int>
+ *           takes 16. Here the one-byte index follows the storage without
+ *           padding: 5 and 9 bytes. The storage may be misaligned, so the
+ *           values are copied in and out with memcpy (a plain load on
+ *           x86), get returns a copy rather than a reference. */
+template<typename... Ts>
+class CompactVariant
+{
+	static_assert((std::is_trivially_copyable_v<Ts> && ...),
+		"CompactVariant holds trivially copyable types only");
+	static_assert(sizeof...(Ts) < 256);
+
+	template<typename T>
+	static constexpr std::uint8_t index_of()
+	{
+		auto i{ std::uint8_t{ 0 } };
+		auto found{ false };
+		((found = found || std::is_same_v<T, Ts>, i += found ? 0 : 1), ...);
+		return i;
+	}
+
+	public:
+		template<std::size_t I>
+		using alternative = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+		CompactVariant() { set(alternative<0>{}); }
+
+		template<typename T>
+			requires (std::is_same_v<std::remove_cvref_t<T>, Ts> || ...)
+		CompactVariant(T value) { set(value); }
+
+		template<typename T>
+			requires (std::is_same_v<std::remove_cvref_t<T>, Ts> || ...)
+		CompactVariant& operator=(T value)
+		{
+			set(value);
+			return *this;
+		}
+
+		std::size_t index() const { return tag; }
+
+		template<typename T>
+		bool holds() const { return tag == index_of<T>(); }
+
+		template<std::size_t I>
+		alternative<I> get() const
+		{
+			if (tag != I) { throw std::bad_variant_access(); }
+			return load<I>();
+		}
+
+		template<typename T>
+		T get() const { return get<index_of<T>()>(); }
+
+		/** \brief Visits the value with a switch on the index */
+		template<typename F>
+		decltype(auto) visit(F&& f) const
+		{
+			return visit_from<0>(std::forward<F>(f));
+		}
+
+	private:
+		template<typename T>
+		void set(T value)
+		{
+			std::memcpy(storage, &value, sizeof(T));
+			tag = index_of<T>();
+		}
+
+		template<std::size_t I>
+		alternative<I> load() const
+		{
+			auto value{ alternative<I>{} };
+			std::memcpy(&value, storage, sizeof(value));
+			return value;
+		}
+
+		template<std::size_t Base, typename F>
+		decltype(auto) visit_from(F&& f) const
+		{
+			constexpr auto size{ sizeof...(Ts) };
+			auto call{
+				[&]<std::size_t I>() -> decltype(auto)
+				{
+					constexpr auto J{ I < size ? I : 0 };
+					return std::invoke(std::forward<F>(f), load<J>());
+				}
+			};
+
+			switch (tag - Base)
+			{
+				case 0: return call.template operator()<Base + 0>();
+				case 1: return call.template operator()<Base + 1>();
+				case 2: return call.template operator()<Base + 2>();
+				case 3: return call.template operator()<Base + 3>();
+				case 4: return call.template operator()<Base + 4>();
+				case 5: return call.template operator()<Base + 5>();
+				case 6: return call.template operator()<Base + 6>();
+				case 7: return call.template operator()<Base + 7>();
+				default:
+					if constexpr (Base + 8 < size)
+					{
+						return visit_from<Base + 8>(
+							std::forward<F>(f));
+					}
+					else
+					{
+						throw std::bad_variant_access();
+					}
+			}
+		}
+
+		std::byte storage[std::max({ sizeof(Ts)... })];
+		std::uint8_t tag;
+} __attribute__((packed));
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Fast variant demo" << std::endl;
+
+	auto lambda{
+		[](bool val) -> std::variant<int, bool>
+		{
+			if (val)
+			{
+				return 300;
+			}
+			else
+			{
+				return false;
+			}
+		}
+	};
+
+	{
+	std::cout << "handling lambda result with fast::visit: ";
+	fast::visit([](auto&& arg) { std::cout << arg; }, lambda(true));
+	fast::visit([](auto&& arg) { std::cout << arg; }, lambda(false));
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "compact variant: ";
+	auto x{ CompactVariant<int, bool>{ 10 } };
+	std::cout << x.get<int>() << " ";
+	x = true;
+	std::cout << x.get<bool>() << " ";
+	x.visit([](auto arg) { std::cout << arg; });
+	std::cout << std::endl;
+
+	std::cout << "sizes: "
+		<< "std::variant<int, bool> " << sizeof(std::variant<int, bool>)
+		<< ", CompactVariant<int, bool> "
+		<< sizeof(CompactVariant<int, bool>)
+		<< ", std::variant<double, int> "
+		<< sizeof(std::variant<double, int>)
+		<< ", CompactVariant<double, int> "
+		<< sizeof(CompactVariant<double, int>) << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n << " variants, ms"
+		<< std::endl;
+
+	using Std = std::variant<int, float, bool, std::int16_t>;
+	using Compact = CompactVariant<int, float, bool, std::int16_t>;
+	auto rng{ std::mt19937{ 42 } };
+	auto std_array{ std::vector<Std>(n) };
+	auto compact_array{ std::vector<Compact>(n) };
+	for (std::size_t i{ 0 }; i < n; i++)
+	{
+		switch (rng() % 4)
+		{
+			case 0: std_array[i] = int(i); break;
+			case 1: std_array[i] = float(i) / 2; break;
+			case 2: std_array[i] = (i % 3 == 0); break;
+			case 3: std_array[i] = std::int16_t(i); break;
+		}
+		std::visit([&](auto v) { compact_array[i] = v; }, std_array[i]);
+	}
+
+	auto to_double{ [](auto v) -> double { return double(v); } };
+	auto a{ 0.0 }, b{ 0.0 }, c{ 0.0 };
+	auto std_ms{ measure([&]() {
+		for (auto& v : std_array) { a += std::visit(to_double, v); } }) };
+	auto fast_ms{ measure([&]() {
+		for (auto& v : std_array) { b += fast::visit(to_double, v); } }) };
+	auto compact_ms{ measure([&]() {
+		for (auto& v : compact_array) { c += v.visit(to_double); } }) };
+
+	std::cout << "std::visit: " << std_ms
+		<< " (" << n * sizeof(Std) << " bytes)" << std::endl;
+	std::cout << "fast::visit: " << fast_ms << std::endl;
+	std::cout << "CompactVariant::visit: " << compact_ms
+		<< " (" << n * sizeof(Compact) << " bytes)" << std::endl;
+	std::cout << (a == b && b == c ? "sums match" : "SUMS DIFFER")
+		<< std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,633 @@
+#include <iostream>
+#include <list>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <new>
+#include <initializer_list>
+#include <type_traits>
+
+// std::list allocates a node per element, the nodes are spread over the heap,
+// and a traversal waits for memory at every step. Two ways to keep the list
+// operations without that: an unrolled list stores a small array of elements
+// per node, so a traversal mostly walks through arrays; an intrusive list
+// keeps the links inside the objects themselves, so linking an object
+// allocates nothing and the object can be found in the list in O(1).
+
+namespace detail
+{
+	struct Links
+	{
+		Links* prev;
+		Links* next;
+	};
+
+	// Links the chain [first, last] before pos
+	inline void link_before(Links* pos, Links* first, Links* last)
+	{
+		first->prev = pos->prev;
+		last->next = pos;
+		pos->prev->next = first;
+		pos->prev = last;
+	}
+
+	inline void unlink(Links* first, Links* last)
+	{
+		first->prev->next = last->next;
+		last->next->prev = first->prev;
+	}
+}
+
+/** \brief   Doubly-linked list of arrays (unrolled linked list)
+ *  \details Every node holds up to Capacity elements, Capacity is chosen so
+ *           that a node is about NodeBytes. A full node is split in two on
+ *           insert, an empty node is freed on erase. Nodes are never
+ *           merged, so the elements of the other nodes don't move: insert
+ *           invalidates the iterators into its node only, erase the
+ *           iterators to the erased element and the ones after it in the
+ *           node. splice keeps all of the iterators to the elements of the
+ *           other list valid, and invalidates the iterators into the node
+ *           of pos if it has to split it. */
+template<typename T, std::size_t NodeBytes = 256>
+class UnrolledList
+{
+	public:
+		static_assert(NodeBytes > sizeof(detail::Links) + sizeof(std::size_t),
+			"NodeBytes is smaller than the node header");
+
+		static constexpr std::size_t Capacity{ std::max<std::size_t>(4,
+			(NodeBytes - sizeof(detail::Links) - sizeof(std::size_t))
+			/ sizeof(T)) };
+
+	private:
+		struct Node : detail::Links
+		{
+			std::size_t count{ 0 };
+			alignas(T) std::byte storage[Capacity * sizeof(T)];
+
+			T* items() { return std::launder(reinterpret_cast<T*>(storage)); }
+		};
+
+		static Node* node(detail::Links* l) { return static_cast<Node*>(l); }
+
+	public:
+		template<bool Const>
+		class Iterator
+		{
+			public:
+				using iterator_category = std::bidirectional_iterator_tag;
+				using value_type = T;
+				using difference_type = std::ptrdiff_t;
+				using pointer = std::conditional_t<Const, const T*, T*>;
+				using reference = std::conditional_t<Const, const T&, T&>;
+
+				Iterator() = default;
+
+				// iterator converts to const_iterator
+				template<bool Other>
+					requires (Const && !Other)
+				Iterator(const Iterator<Other>& other)
+					: links(other.links), index(other.index)
+				{
+				}
+
+				reference operator*() const
+				{
+					return node(links)->items()[index];
+				}
+
+				pointer operator->() const { return &**this; }
+
+				Iterator& operator++()
+				{
+					if (++index == node(links)->count)
+					{
+						links = links->next;
+						index = 0;
+					}
+					return *this;
+				}
+
+				Iterator operator++(int)
+				{
+					auto copy{ *this };
+					++*this;
+					return copy;
+				}
+
+				Iterator& operator--()
+				{
+					if (index == 0)
+					{
+						links = links->prev;
+						index = node(links)->count;
+					}
+					index--;
+					return *this;
+				}
+
+				Iterator operator--(int)
+				{
+					auto copy{ *this };
+					--*this;
+					return copy;
+				}
+
+				bool operator==(const Iterator&) const = default;
+
+			private:
+				friend class UnrolledList;
+				friend class Iterator<!Const>;
+
+				Iterator(detail::Links* links, std::size_t index)
+					: links(links), index(index)
+				{
+				}
+
+				detail::Links* links{ nullptr };
+				std::size_t index{ 0 };
+		};
+
+		using value_type = T;
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		UnrolledList() = default;
+
+		UnrolledList(std::initializer_list<T> values)
+		{
+			for (auto& v : values) { push_back(v); }
+		}
+
+		UnrolledList(const UnrolledList&) = delete;
+		UnrolledList& operator=(const UnrolledList&) = delete;
+
+		~UnrolledList() { clear(); }
+
+		iterator begin() { return { root.next, 0 }; }
+		iterator end() { return { &root, 0 }; }
+		const_iterator begin() const { return { root.next, 0 }; }
+		const_iterator end() const
+		{
+			return { const_cast<detail::Links*>(&root), 0 };
+		}
+
+		std::size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		T& front() { return *begin(); }
+		T& back() { return *std::prev(end()); }
+
+		template<typename... Args>
+		iterator emplace(const_iterator pos, Args&&... args)
+		{
+			auto* n{ node(pos.links) };
+			auto i{ pos.index };
+			if (pos.links == &root)
+			{
+				// At the end: append to the last node or start a new one
+				n = node(root.prev);
+				if (root.prev == &root || n->count == Capacity)
+				{
+					n = new Node{};
+					detail::link_before(&root, n, n);
+				}
+				i = n->count;
+			}
+			else if (n->count == Capacity)
+			{
+				n = split(n, Capacity / 2);
+				if (i >= Capacity / 2) { i -= Capacity / 2; }
+				else { n = node(n->prev); }
+			}
+
+			auto* items{ n->items() };
+			if (i == n->count)
+			{
+				new (items + i) T(std::forward<Args>(args)...);
+			}
+			else
+			{
+				// Make the value first, the arguments may refer to the
+				// elements that are moved
+				auto value{ T(std::forward<Args>(args)...) };
+				new (items + n->count) T(std::move(items[n->count - 1]));
+				std::move_backward(items + i, items + n->count - 1,
+					items + n->count);
+				items[i] = std::move(value);
+			}
+			n->count++;
+			count++;
+			return { n, i };
+		}
+
+		iterator insert(const_iterator pos, T value)
+		{
+			return emplace(pos, std::move(value));
+		}
+
+		template<typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			return *emplace(end(), std::forward<Args>(args)...);
+		}
+
+		void push_back(T value) { emplace(end(), std::move(value)); }
+
+		void push_front(T value) { emplace(begin(), std::move(value)); }
+
+		/** \brief Removes the element, returns the iterator to the next */
+		iterator erase(const_iterator pos)
+		{
+			auto* n{ node(pos.links) };
+			auto i{ pos.index };
+			auto* items{ n->items() };
+			std::move(items + i + 1, items + n->count, items + i);
+			items[n->count - 1].~T();
+			n->count--;
+			count--;
+
+			if (n->count == 0)
+			{
+				auto* next{ n->next };
+				detail::unlink(n, n);
+				delete n;
+				return { next, 0 };
+			}
+			if (i == n->count) { return { n->next, 0 }; }
+			return { n, i };
+		}
+
+		/** \brief   Moves all of the elements of the other list before pos
+		 *  \details The nodes are relinked, the elements don't move. Costs
+		 *           O(Capacity) if pos is in the middle of a node. */
+		void splice(const_iterator pos, UnrolledList& other)
+		{
+			if (other.empty() || &other == this) { return; }
+			auto* at{ pos.links };
+			if (pos.index != 0) { at = split(node(at), pos.index); }
+			auto* first{ other.root.next };
+			auto* last{ other.root.prev };
+			detail::unlink(first, last);
+			detail::link_before(at, first, last);
+			count += other.count;
+			other.count = 0;
+		}
+
+		void clear()
+		{
+			for (auto* l{ root.next }; l != &root;)
+			{
+				auto* n{ node(l) };
+				l = l->next;
+				for (std::size_t i{ 0 }; i < n->count; i++)
+				{
+					n->items()[i].~T();
+				}
+				delete n;
+			}
+			root = { &root, &root };
+			count = 0;
+		}
+
+	private:
+		// Moves the elements from the index on into a new node after n
+		Node* split(Node* n, std::size_t index)
+		{
+			auto* right{ new Node{} };
+			auto* from{ n->items() };
+			auto* to{ right->items() };
+			for (auto i{ index }; i < n->count; i++)
+			{
+				new (to + i - index) T(std::move(from[i]));
+				from[i].~T();
+			}
+			right->count = n->count - index;
+			n->count = index;
+			detail::link_before(n->next, right, right);
+			return right;
+		}
+
+		detail::Links root{ &root, &root };
+		std::size_t count{ 0 };
+};
+
+/** \brief   Links of an object in an IntrusiveList, inherit from it
+ *  \details The Tag tells the hooks apart when the object is in several
+ *           lists at once. Copies of the object are not linked. */
+template<typename Tag = void>
+class ListHook : private detail::Links
+{
+	public:
+		ListHook() : detail::Links{ nullptr, nullptr } {}
+		ListHook(const ListHook&) : ListHook() {}
+		ListHook& operator=(const ListHook&) { return *this; }
+
+		bool is_linked() const { return next != nullptr; }
+
+	private:
+		template<typename, typename> friend class IntrusiveList;
+};
+
+/** \brief   Doubly-linked list of objects that inherit from ListHook<Tag>
+ *  \details The list doesn't own the objects: they must stay alive while they
+ *           are linked, and they never move, so all of the iterators stay
+ *           valid until the element is removed. Insert, erase, remove and
+ *           splice are O(1) and allocate nothing. */
+template<typename T, typename Tag = void>
+class IntrusiveList
+{
+	using Hook = ListHook<Tag>;
+
+	static detail::Links* links(T& value)
+	{
+		return static_cast<detail::Links*>(static_cast<Hook*>(&value));
+	}
+
+	static T& object(detail::Links* l)
+	{
+		return static_cast<T&>(static_cast<Hook&>(*l));
+	}
+
+	public:
+		class iterator
+		{
+			public:
+				using iterator_category = std::bidirectional_iterator_tag;
+				using value_type = T;
+				using difference_type = std::ptrdiff_t;
+				using pointer = T*;
+				using reference = T&;
+
+				iterator() = default;
+
+				T& operator*() const { return object(l); }
+				T* operator->() const { return &object(l); }
+
+				iterator& operator++() { l = l->next; return *this; }
+				iterator& operator--() { l = l->prev; return *this; }
+
+				iterator operator++(int)
+				{
+					auto copy{ *this };
+					l = l->next;
+					return copy;
+				}
+
+				iterator operator--(int)
+				{
+					auto copy{ *this };
+					l = l->prev;
+					return copy;
+				}
+
+				bool operator==(const iterator&) const = default;
+
+			private:
+				friend class IntrusiveList;
+				explicit iterator(detail::Links* l) : l(l) {}
+				detail::Links* l{ nullptr };
+		};
+
+		IntrusiveList() = default;
+		IntrusiveList(const IntrusiveList&) = delete;
+		IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+		~IntrusiveList() { clear(); }
+
+		iterator begin() { return iterator{ root.next }; }
+		iterator end() { return iterator{ &root }; }
+
+		std::size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		T& front() { return object(root.next); }
+		T& back() { return object(root.prev); }
+
+		/** \brief The iterator of a linked object, no search */
+		static iterator iterator_to(T& value)
+		{
+			return iterator{ links(value) };
+		}
+
+		/** \brief Links the object before pos, it must not be linked */
+		iterator insert(iterator pos, T& value)
+		{
+			auto* l{ links(value) };
+			detail::link_before(pos.l, l, l);
+			count++;
+			return iterator{ l };
+		}
+
+		void push_back(T& value) { insert(end(), value); }
+		void push_front(T& value) { insert(begin(), value); }
+
+		/** \brief Unlinks the object, returns the iterator to the next */
+		iterator erase(iterator pos)
+		{
+			auto* next{ pos.l->next };
+			detail::unlink(pos.l, pos.l);
+			*pos.l = { nullptr, nullptr };
+			count--;
+			return iterator{ next };
+		}
+
+		void remove(T& value) { erase(iterator_to(value)); }
+
+		void pop_front() { erase(begin()); }
+		void pop_back() { erase(iterator{ root.prev }); }
+
+		/** \brief Moves all of the objects of the other list before pos */
+		void splice(iterator pos, IntrusiveList& other)
+		{
+			if (other.empty() || &other == this) { return; }
+			auto* first{ other.root.next };
+			auto* last{ other.root.prev };
+			detail::unlink(first, last);
+			detail::link_before(pos.l, first, last);
+			count += other.count;
+			other.count = 0;
+		}
+
+		/** \brief Moves one object of the other list before pos */
+		void splice(iterator pos, IntrusiveList& other, iterator it)
+		{
+			if (pos == it) { return; }
+			detail::unlink(it.l, it.l);
+			detail::link_before(pos.l, it.l, it.l);
+			other.count--;
+			count++;
+		}
+
+		/** \brief Unlinks all of the objects */
+		void clear()
+		{
+			for (auto* l{ root.next }; l != &root;)
+			{
+				auto* next{ l->next };
+				*l = { nullptr, nullptr };
+				l = next;
+			}
+			root = { &root, &root };
+			count = 0;
+		}
+
+	private:
+		detail::Links root{ &root, &root };
+		std::size_t count{ 0 };
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Unrolled and intrusive linked list demo" << std::endl;
+
+	{
+	// Same operations as the std::list<std::string> in containers.cpp
+	auto x{ UnrolledList<std::string>{ "foo", "bar" } };
+	auto y{ UnrolledList<std::string>{ "baz" } };
+	x.push_front("first");
+	auto it{ x.insert(std::next(x.begin()), "second") };
+	x.splice(x.end(), y);
+	std::cout << "unrolled list, " << decltype(x)::Capacity
+		<< " strings per node: ";
+	for (auto& s : x) { std::cout << s << " "; }
+	std::cout << "(still at " << *it << ", other list has " << y.size()
+		<< ")" << std::endl;
+
+	// A task is in the list of all tasks and maybe in the ready queue
+	struct All {};
+	struct Ready {};
+	struct Task : ListHook<All>, ListHook<Ready>
+	{
+		std::string name;
+		Task(std::string name) : name(std::move(name)) {}
+	};
+	auto tasks{ std::vector<Task>{ { "parse" }, { "load" }, { "draw" } } };
+	auto all{ IntrusiveList<Task, All>{} };
+	auto ready{ IntrusiveList<Task, Ready>{} };
+	for (auto& t : tasks) { all.push_back(t); }
+	ready.push_back(tasks[2]);
+	ready.push_back(tasks[0]);
+	ready.remove(tasks[2]);
+	std::cout << "intrusive lists, all: ";
+	for (auto& t : all) { std::cout << t.name << " "; }
+	std::cout << "ready: ";
+	for (auto& t : ready) { std::cout << t.name << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	// Inserts before the middle element, vector moves half of the array
+	// every time, so there are fewer of them
+	auto inserts{ std::max(1l, n / 1000) };
+	std::cout << std::endl << "Benchmark, " << n << " ints, " << inserts
+		<< " inserts in the middle, ms" << std::endl;
+
+	// Runs the same steps with any of the containers: push_back, sum,
+	// insert at the middle, erase every other element, sum again
+	auto run{ [&](const char* name, auto& c, auto push, auto insert,
+		auto erase_odd) {
+		auto sum{ [&]() { auto s{ 0l }; for (auto& v : c) { s += v; }
+			return s; } };
+		auto before{ 0l };
+		auto after{ 0l };
+		auto push_ms{ measure([&]() {
+			for (long i{ 0 }; i < n; i++) { push(i); } }) };
+		auto iterate_ms{ measure([&]() { before = sum(); }) };
+		auto insert_ms{ measure([&]() { insert(); }) };
+		auto erase_ms{ measure([&]() { erase_odd(); }) };
+		after = sum();
+		std::cout << name << ": push_back: " << push_ms
+			<< " iterate: " << iterate_ms << " insert: " << insert_ms
+			<< " erase: " << erase_ms << " (sums " << before << " "
+			<< after << ")" << std::endl;
+	} };
+
+	{
+	auto l{ std::list<int>{} };
+	run("std::list", l, [&](int i) { l.push_back(i); },
+		[&]() {
+			auto middle{ std::next(l.begin(), n / 2) };
+			for (long i{ 0 }; i < inserts; i++) { l.insert(middle, -1); } },
+		[&]() {
+			auto odd{ false };
+			for (auto it{ l.begin() }; it != l.end(); odd = !odd)
+			{
+				it = odd ? l.erase(it) : std::next(it);
+			} });
+	}
+
+	{
+	auto v{ std::vector<int>{} };
+	run("std::vector", v, [&](int i) { v.push_back(i); },
+		[&]() {
+			for (long i{ 0 }; i < inserts; i++)
+			{
+				v.insert(v.begin() + n / 2, -1);
+			} },
+		[&]() {
+			auto odd{ false };
+			std::erase_if(v, [&](int) { odd = !odd; return !odd; }); });
+	}
+
+	{
+	auto u{ UnrolledList<int>{} };
+	run("UnrolledList", u, [&](int i) { u.push_back(i); },
+		[&]() {
+			auto middle{ std::next(u.begin(), n / 2) };
+			for (long i{ 0 }; i < inserts; i++)
+			{
+				// The insert may split the node, the element moves
+				middle = std::next(u.insert(middle, -1));
+			} },
+		[&]() {
+			auto odd{ false };
+			for (auto it{ u.begin() }; it != u.end(); odd = !odd)
+			{
+				it = odd ? u.erase(it) : std::next(it);
+			} });
+	}
+
+	{
+	// The objects are allocated once up front, linking allocates nothing
+	struct Item : ListHook<>
+	{
+		int value;
+		operator int() const { return value; }
+	};
+	auto items{ std::vector<Item>(n + inserts) };
+	auto l{ IntrusiveList<Item>{} };
+	run("IntrusiveList", l,
+		[&](int i) { items[i].value = i; l.push_back(items[i]); },
+		[&]() {
+			auto middle{ IntrusiveList<Item>::iterator_to(items[n / 2]) };
+			for (long i{ 0 }; i < inserts; i++)
+			{
+				items[n + i].value = -1;
+				l.insert(middle, items[n + i]);
+			} },
+		[&]() {
+			auto odd{ false };
+			for (auto it{ l.begin() }; it != l.end(); odd = !odd)
+			{
+				it = odd ? l.erase(it) : std::next(it);
+			} });
+	}
+	}
+
+	return 0;
+}
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include "type_name.h"
 
 class DummyClass
 {
@@ -38,7 +39,7 @@ int main(int argc, char** argv)
 		// out the scope, DummyClass would be automatically destroyed
 		// and the memory would be freed
 		auto x{ std::make_unique<DummyClass>("unique_ptr") };
-		std::cout << "x is " << typeid(decltype(x)).name() << std::endl;
+		std::cout << "x is " << type_name<decltype(x)>() << std::endl;
 		std::cout << x->name << std::endl;
 
 		// This pointer can not be copied or passed to the function
@@ -55,11 +56,11 @@ int main(int argc, char** argv)
 		// and the memory freed, but it happens when all of the
 		// holding variables outs of scope.
 		auto x{ std::make_shared<DummyClass>("shared_ptr") };
-		std::cout << "x is " << typeid(decltype(x)).name() << std::endl;
+		std::cout << "x is " << type_name<decltype(x)>() << std::endl;
 		std::cout << x->name << std::endl;
 
 		auto y = x;
-		std::cout << "y is " << typeid(decltype(y)).name() << std::endl;
+		std::cout << "y is " << type_name<decltype(y)>() << std::endl;
 		std::cout << y->name << std::endl;
 	}
 
@@ -72,12 +73,12 @@ int main(int argc, char** argv)
 		// to the holding data, but you can see the health of the
 		// pointer.
 		std::weak_ptr<DummyClass> y;
-		std::cout << "y is " << typeid(decltype(y)).name() << std::endl;
+		std::cout << "y is " << type_name<decltype(y)>() << std::endl;
 		std::cout << (y.expired() ? "invalid" : "valid") << std::endl;
 
 		{
 			auto x{ std::make_shared<DummyClass>("shared_ptr") };
-			std::cout << "x is " << typeid(decltype(x)).name()
+			std::cout << "x is " << type_name<decltype(x)>()
 				<< std::endl;
 			std::cout << x->name << std::endl;
 
@@ -146,18 +146,24 @@ int main(int argc, char** argv)
 	// Semaphore allows numerous lock attempts before it would be locked
 	// as mutex.
 	auto s{ std::counting_semaphore(3) };
+	// Active threads print at the same time, the lines shouldn't mix
+	auto output{ std::mutex{} };
 	auto func{
 		[&](int num) -> void
 		{
 			s.acquire();
-			std::cout << std::flush
-				<< "Thread " << num << "started"
-				<< std::endl;
+			{
+				auto lock{ std::lock_guard(output) };
+				std::cout << "Thread " << num << "started"
+					<< std::endl;
+			}
 			std::this_thread::sleep_for(
 					std::chrono::milliseconds(500));
-			std::cout << std::flush
-				<< "Thread " << num << "ended"
-				<< std::endl;
+			{
+				auto lock{ std::lock_guard(output) };
+				std::cout << "Thread " << num << "ended"
+					<< std::endl;
+			}
 			s.release();
 		}
 	};
@@ -206,25 +212,33 @@ int main(int argc, char** argv)
 
 	auto t{ std::vector<std::thread>{} };
 	for (int i{ 0 }; i < 3; i++) { t.push_back(std::thread{ func, i+1 }); }
-	for (auto& thread : t) { thread.detach(); }
 
 	std::cout << "waiting for threads: ";
 	// Note: you may wait only once! Latches are not reusable.
 	sync_point.wait();
 
 	std::cout << "..." << std::endl;
+	// The threads still run after count_down, they should finish before
+	// the latch is destroyed
+	for (auto& thread : t) { thread.join(); }
 	}
 
 	{
 	std::cout << "remote control of threads with conditional variable: ";
+	// The waiting condition is a shared state protected by one mutex.
+	// Notification itself is not remembered: a thread that starts
+	// waiting after notify would sleep forever, and waits may wake up
+	// spuriously. So threads wait for the state, not for the signal.
 	auto cv{ std::condition_variable{} };
+	auto m{ std::mutex{} };
+	auto permits{ 0 };
 	auto func {
 		[&]() -> void
 		{
-			auto m{ std::mutex{} };
 			auto lock{ std::unique_lock<std::mutex>{ m } };
 			std::cout << ">" << std::flush;
-			cv.wait(lock);
+			cv.wait(lock, [&]() { return permits > 0; });
+			permits--;
 			std::cout << "<" << std::flush;
 		}
 	};
@@ -232,9 +246,17 @@ int main(int argc, char** argv)
 	for (int i{ 0 }; i < 3; i++) { t.push_back(std::thread{ func }); }
 
 	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+	{
+		auto lock{ std::lock_guard(m) };
+		permits += 1;
+	}
 	cv.notify_one(); // one of the waiting threads would be unlocked
-	
+
 	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+	{
+		auto lock{ std::lock_guard(m) };
+		permits += 2;
+	}
 	cv.notify_all(); // rest of the waiting threads would be unlocked
 
 	for (auto& thread : t) { thread.join(); }
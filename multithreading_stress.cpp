@@ -0,0 +1,292 @@
+#include <iostream>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <semaphore>
+#include <barrier>
+#include <latch>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <random>
+#include <chrono>
+#include <string>
+#include <stdexcept>
+
+// Stress checks for the patterns of multithreading.cpp. Every check runs many
+// iterations on several threads, shakes the schedule with random yields and
+// short sleeps, verifies the result and reports the throughput. It's meant to
+// be run under ThreadSanitizer as well:
+// make build/tsan/multithreading_stress.example
+// ./build/tsan/multithreading_stress.example
+
+/** \brief Randomly yields or sleeps to change the order of the threads */
+class Jitter
+{
+	public:
+		explicit Jitter(unsigned seed) : rng(seed) {}
+
+		void operator()()
+		{
+			auto r{ rng() % 64 };
+			if (r == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(10));
+			}
+			else if (r < 8)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+	private:
+		std::mt19937 rng;
+};
+
+/** \brief Runs f(id) on n threads and joins them */
+template<typename F>
+void run_threads(int n, F&& f)
+{
+	auto t{ std::vector<std::thread>{} };
+	for (int id{ 0 }; id < n; id++) { t.push_back(std::thread{ f, id }); }
+	for (auto& _t : t) { _t.join(); }
+}
+
+/** \brief Prints the result of the check, returns true if it passed */
+bool report(const char* name, bool ok, double ops, double ms)
+{
+	std::cout << name << ": " << (ok ? "ok" : "FAILED") << ", "
+		<< ops / ms * 1000 << " ops/s" << std::endl;
+	return ok;
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Multithreading primitives stress test" << std::endl;
+
+	auto n{ argc > 1 ? std::stol(argv[1]) : 100'000l };
+	auto threads{ 4 };
+	auto ok{ true };
+	std::cout << threads << " threads, " << n << " iterations per check"
+		<< std::endl;
+
+	{
+	// Non-atomic counter under the mutex
+	auto m{ std::mutex{} };
+	auto counter{ 0l };
+	auto ms{ measure([&]() {
+		run_threads(threads, [&](int id) {
+			auto jitter{ Jitter(id) };
+			for (long i{ 0 }; i < n; i++)
+			{
+				jitter();
+				auto lock{ std::lock_guard(m) };
+				counter++;
+			}
+		}); }) };
+	ok &= report("mutex", counter == threads * n, threads * n, ms);
+	}
+
+	{
+	// Counter and read-modify-write of the atomic double
+	auto counter{ std::atomic<long>{ 0 } };
+	auto sum{ std::atomic<double>{ 0 } };
+	auto ms{ measure([&]() {
+		run_threads(threads, [&](int id) {
+			auto jitter{ Jitter(id) };
+			for (long i{ 0 }; i < n; i++)
+			{
+				jitter();
+				counter.fetch_add(1, std::memory_order_relaxed);
+				auto old{ sum.load() };
+				while (!sum.compare_exchange_weak(old, old + 1.0)) {}
+			}
+		}); }) };
+	ok &= report("atomic", counter == threads * n
+		&& sum == double(threads * n), threads * n, ms);
+	}
+
+	{
+	// No more than 2 threads are inside at the same time
+	constexpr int limit{ 2 };
+	auto s{ std::counting_semaphore<limit>(limit) };
+	auto inside{ std::atomic<int>{ 0 } };
+	auto max_inside{ std::atomic<int>{ 0 } };
+	auto ms{ measure([&]() {
+		run_threads(threads, [&](int id) {
+			auto jitter{ Jitter(id) };
+			for (long i{ 0 }; i < n / 10; i++)
+			{
+				s.acquire();
+				auto now{ inside.fetch_add(1) + 1 };
+				auto max{ max_inside.load() };
+				while (now > max
+					&& !max_inside.compare_exchange_weak(max, now)) {}
+				jitter();
+				inside.fetch_sub(1);
+				s.release();
+			}
+		}); }) };
+	ok &= report("semaphore", max_inside <= limit, threads * (n / 10), ms);
+	}
+
+	{
+	// Every thread writes its slot, after the barrier all of the slots
+	// should be of the same round. The completion function runs while all
+	// of the threads wait, so it may read the slots.
+	auto rounds{ n / 100 };
+	auto slots{ std::vector<long>(threads, -1) };
+	auto round{ 0l };
+	auto good{ true };
+	auto sync_point{ std::barrier(threads, [&]() noexcept {
+		for (auto s : slots) { good = good && s == round; }
+		round++;
+	}) };
+	auto ms{ measure([&]() {
+		run_threads(threads, [&](int id) {
+			auto jitter{ Jitter(id) };
+			for (long r{ 0 }; r < rounds; r++)
+			{
+				jitter();
+				slots[id] = r;
+				sync_point.arrive_and_wait();
+			}
+		}); }) };
+	ok &= report("barrier", good && round == rounds, rounds, ms);
+	}
+
+	{
+	// The writes before count_down are visible after wait. The threads
+	// are joined, so they don't outlive the latch.
+	auto rounds{ n / 1000 };
+	auto good{ true };
+	auto ms{ measure([&]() {
+		for (long r{ 0 }; r < rounds; r++)
+		{
+			auto done{ std::latch(threads) };
+			auto results{ std::vector<long>(threads) };
+			auto t{ std::vector<std::thread>{} };
+			for (int id{ 0 }; id < threads; id++)
+			{
+				t.push_back(std::thread{ [&, id]() {
+					auto jitter{ Jitter(r * threads + id) };
+					jitter();
+					results[id] = r + id;
+					done.count_down();
+				} });
+			}
+			done.wait();
+			for (int id{ 0 }; id < threads; id++)
+			{
+				good = good && results[id] == r + id;
+			}
+			for (auto& _t : t) { _t.join(); }
+		} }) };
+	ok &= report("latch", good, rounds, ms);
+	}
+
+	{
+	// One thread fulfills the promises, some of them with exceptions
+	auto count{ n / 10 };
+	auto promises{ std::vector<std::promise<long>>(count) };
+	auto futures{ std::vector<std::future<long>>{} };
+	for (auto& p : promises) { futures.push_back(p.get_future()); }
+	auto good{ true };
+	auto ms{ measure([&]() {
+		auto producer{ std::thread{ [&]() {
+			auto jitter{ Jitter(42) };
+			for (long i{ 0 }; i < count; i++)
+			{
+				jitter();
+				if (i % 100 == 0)
+				{
+					promises[i].set_exception(std::make_exception_ptr(
+						std::runtime_error("no value")));
+				}
+				else
+				{
+					promises[i].set_value(i);
+				}
+			}
+		} } };
+		for (long i{ 0 }; i < count; i++)
+		{
+			auto expected_exception{ i % 100 == 0 };
+			try
+			{
+				good = good && futures[i].get() == i && !expected_exception;
+			}
+			catch (const std::runtime_error&)
+			{
+				good = good && expected_exception;
+			}
+		}
+		producer.join(); }) };
+	ok &= report("promise/future", good, count, ms);
+	}
+
+	{
+	// Bounded queue: producers wait while it's full, consumers while it's
+	// empty. Every wait has a predicate on the state under the same mutex.
+	auto m{ std::mutex{} };
+	auto not_full{ std::condition_variable{} };
+	auto not_empty{ std::condition_variable{} };
+	auto queue{ std::deque<long>{} };
+	constexpr std::size_t capacity{ 16 };
+	auto producers{ threads / 2 };
+	auto per_producer{ n / 10 };
+	auto finished{ 0 };
+	auto sum{ std::atomic<long>{ 0 } };
+
+	auto ms{ measure([&]() {
+		run_threads(threads, [&](int id) {
+			auto jitter{ Jitter(id) };
+			if (id < producers)
+			{
+				for (long i{ 1 }; i <= per_producer; i++)
+				{
+					jitter();
+					auto lock{ std::unique_lock(m) };
+					not_full.wait(lock,
+						[&]() { return queue.size() < capacity; });
+					queue.push_back(i);
+					not_empty.notify_one();
+				}
+				auto lock{ std::lock_guard(m) };
+				finished++;
+				not_empty.notify_all();
+			}
+			else
+			{
+				while (true)
+				{
+					jitter();
+					auto lock{ std::unique_lock(m) };
+					not_empty.wait(lock, [&]() {
+						return !queue.empty() || finished == producers; });
+					if (queue.empty()) { break; }
+					sum += queue.front();
+					queue.pop_front();
+					not_full.notify_one();
+				}
+			}
+		}); }) };
+	auto expected{ producers * per_producer * (per_producer + 1) / 2 };
+	ok &= report("condition_variable", sum == expected,
+		producers * per_producer, ms);
+	}
+
+	std::cout << (ok ? "all checks passed" : "SOME CHECKS FAILED")
+		<< std::endl;
+	return ok ? 0 : 1;
+}
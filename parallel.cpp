@@ -0,0 +1,412 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <array>
+#include <optional>
+#include <ranges>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+#include <tuple>
+#include <string>
+
+// Splitting the work into one part per thread works when all of the parts
+// take the same time. Here the range is split recursively into tasks: a
+// thread takes a range, leaves the right half to the other threads and goes
+// on with the left half. Threads that finish early take the halves left by
+// the others, so the load is balanced while the tasks are big enough to make
+// the cost of the queue negligible.
+
+namespace parallel
+{
+	/** \brief   Pool of workers sharing one task queue
+	 *  \details Waiting threads run the tasks too, so a task may start the
+	 *           nested parallel loop without a deadlock. */
+	class ThreadPool
+	{
+		public:
+			struct Task
+			{
+				void (*run)(void* job, std::size_t begin, std::size_t end);
+				void* job;
+				std::size_t begin;
+				std::size_t end;
+			};
+
+			explicit ThreadPool(unsigned workers)
+			{
+				for (unsigned i{ 0 }; i < workers; i++)
+				{
+					threads.push_back(std::thread{ [this]() { work(); } });
+				}
+			}
+
+			~ThreadPool()
+			{
+				{
+					auto lock{ std::lock_guard(m) };
+					stop = true;
+				}
+				cv.notify_all();
+				for (auto& t : threads) { t.join(); }
+			}
+
+			void push(Task task)
+			{
+				{
+					auto lock{ std::lock_guard(m) };
+					tasks.push_back(task);
+				}
+				cv.notify_one();
+			}
+
+			/** \brief Runs one queued task, false if there's none */
+			bool run_one()
+			{
+				auto task{ pop() };
+				if (!task) { return false; }
+				task->run(task->job, task->begin, task->end);
+				return true;
+			}
+
+			/** \brief Worker threads and the calling thread */
+			unsigned concurrency() const { return threads.size() + 1; }
+
+		private:
+			std::optional<Task> pop()
+			{
+				auto lock{ std::lock_guard(m) };
+				if (tasks.empty()) { return std::nullopt; }
+				auto task{ tasks.back() };
+				tasks.pop_back();
+				return task;
+			}
+
+			void work()
+			{
+				while (true)
+				{
+					auto lock{ std::unique_lock(m) };
+					cv.wait(lock, [&]() { return stop || !tasks.empty(); });
+					if (stop) { return; }
+					auto task{ tasks.back() };
+					tasks.pop_back();
+					lock.unlock();
+					task.run(task.job, task.begin, task.end);
+				}
+			}
+
+			std::mutex m;
+			std::condition_variable cv;
+			std::deque<Task> tasks;
+			bool stop{ false };
+			std::vector<std::thread> threads;
+	};
+
+	/** \brief The pool shared by all of the parallel loops */
+	inline ThreadPool& pool()
+	{
+		static auto instance{ ThreadPool(
+			std::max(1u, std::thread::hardware_concurrency()) - 1) };
+		return instance;
+	}
+
+	struct Options
+	{
+		/** \brief Items per task, 0 means measured at runtime */
+		std::size_t grain{ 0 };
+		/** \brief   Reduce parts in the order of the range
+		 *  \details The range is cut into parts of the fixed size
+		 *           (grain, or 16384 if it's 0), and the results of the
+		 *           parts are combined from left to right. The result
+		 *           doesn't depend on the threads or the timing, which
+		 *           matters for floating point sums. */
+		bool deterministic{ false };
+	};
+
+	namespace detail
+	{
+		// Wanted duration of one task: long enough to hide the queue,
+		// short enough to balance the load
+		constexpr auto target_ns{ 50'000.0 };
+		constexpr std::size_t deterministic_grain{ 16384 };
+
+		template<typename Body>
+		struct Job
+		{
+			Body& body;
+			std::size_t grain;
+			std::atomic<std::size_t> remaining;
+		};
+
+		template<typename Body>
+		void execute(void* p, std::size_t begin, std::size_t end)
+		{
+			auto& job{ *static_cast<Job<Body>*>(p) };
+			while (end - begin > job.grain)
+			{
+				auto middle{ begin + (end - begin) / 2 };
+				pool().push({ &execute<Body>, p, middle, end });
+				end = middle;
+			}
+			job.body(begin, end);
+			// The last access to the job: the caller may return after it
+			job.remaining.fetch_sub(end - begin, std::memory_order_release);
+		}
+
+		/** \brief Runs body(begin, end) on the parts of [begin, end) and
+		 *         returns when all of them are done */
+		template<typename Body>
+		void run(std::size_t begin, std::size_t end, std::size_t grain,
+			Body& body)
+		{
+			if (begin >= end) { return; }
+			auto job{ Job<Body>{ body, std::max<std::size_t>(1, grain),
+				end - begin } };
+			execute<Body>(&job, begin, end);
+			while (job.remaining.load(std::memory_order_acquire) != 0)
+			{
+				if (!pool().run_one()) { std::this_thread::yield(); }
+			}
+		}
+
+		/** \brief   Measures the first items on the calling thread and
+		 *           chooses the grain for the rest
+		 *  \return  The index of the first unprocessed item and the grain */
+		template<typename Body>
+		std::pair<std::size_t, std::size_t> probe(std::size_t begin,
+			std::size_t end, Body& body)
+		{
+			auto count{ std::min<std::size_t>(end - begin, 256) };
+			auto start{ std::chrono::steady_clock::now() };
+			body(begin, begin + count);
+			auto ns{ std::chrono::duration<double, std::nano>(
+				std::chrono::steady_clock::now() - start).count() };
+
+			auto per_item{ std::max(ns / std::max<std::size_t>(count, 1),
+				0.01) };
+			// At least 8 tasks per thread for the balance
+			auto most{ std::max<std::size_t>(1, (end - begin)
+				/ (8 * pool().concurrency())) };
+			auto grain{ std::clamp<std::size_t>(
+				std::size_t(target_ns / per_item), 1, most) };
+			return { begin + count, grain };
+		}
+	}
+
+	/** \brief Calls f(i) for every i in [begin, end) on all of the threads */
+	template<typename F>
+	void parallel_for(std::size_t begin, std::size_t end, F f,
+		Options options = {})
+	{
+		auto body{ [&](std::size_t b, std::size_t e) {
+			for (auto i{ b }; i < e; i++) { f(i); } } };
+		auto grain{ options.grain };
+		if (grain == 0 && begin < end)
+		{
+			std::tie(begin, grain) = detail::probe(begin, end, body);
+		}
+		detail::run(begin, end, grain, body);
+	}
+
+	/** \brief Calls f(item) for every item of the random access range */
+	template<std::ranges::random_access_range R, typename F>
+	void parallel_for(R&& range, F f, Options options = {})
+	{
+		auto first{ std::ranges::begin(range) };
+		parallel_for(0, std::ranges::size(range),
+			[&](std::size_t i) { f(first[i]); }, options);
+	}
+
+	/** \brief   Reduces the range: reduce(T, item) folds the items of a
+	 *           part, combine(T, T) joins the results of the parts
+	 *  \details init is the start of every part, so it should be the
+	 *           identity: 0 for the sum, an empty histogram and so on. For
+	 *           big values reduce may take T& and update it in place
+	 *           instead of returning a copy per item. */
+	template<std::ranges::random_access_range R, typename T,
+		typename Reduce, typename Combine>
+	T parallel_reduce(R&& range, T init, Reduce reduce, Combine combine,
+		Options options = {})
+	{
+		auto first{ std::ranges::begin(range) };
+		std::size_t n{ std::ranges::size(range) };
+		auto fold{ [&](std::size_t b, std::size_t e) {
+			auto acc{ init };
+			for (auto i{ b }; i < e; i++)
+			{
+				if constexpr (std::is_void_v<std::invoke_result_t<Reduce&,
+					T&, decltype(first[i])>>)
+				{
+					reduce(acc, first[i]);
+				}
+				else
+				{
+					acc = reduce(std::move(acc), first[i]);
+				}
+			}
+			return acc; } };
+
+		if (options.deterministic)
+		{
+			auto grain{ options.grain ? options.grain
+				: detail::deterministic_grain };
+			auto parts{ std::vector<T>((n + grain - 1) / grain, init) };
+			auto body{ [&](std::size_t b, std::size_t e) {
+				for (auto p{ b }; p < e; p++)
+				{
+					parts[p] = fold(p * grain, std::min(n, (p + 1) * grain));
+				} } };
+			detail::run(0, parts.size(), 1, body);
+			auto result{ init };
+			for (auto& p : parts) { result = combine(result, p); }
+			return result;
+		}
+
+		auto m{ std::mutex{} };
+		auto result{ init };
+		auto body{ [&](std::size_t b, std::size_t e) {
+			auto acc{ fold(b, e) };
+			auto lock{ std::lock_guard(m) };
+			result = combine(result, acc); } };
+		auto begin{ std::size_t{ 0 } };
+		auto grain{ options.grain };
+		if (grain == 0 && n > 0)
+		{
+			std::tie(begin, grain) = detail::probe(0, n, body);
+		}
+		detail::run(begin, n, grain, body);
+		return result;
+	}
+
+	/** \brief Reduces the range with one operation, like std::reduce */
+	template<std::ranges::random_access_range R, typename T, typename Op>
+	T parallel_reduce(R&& range, T init, Op op, Options options = {})
+	{
+		return parallel_reduce(std::forward<R>(range), init, op, op, options);
+	}
+}
+
+/** \brief The usual way: one equal part per thread */
+template<typename F>
+void thread_vector(std::size_t n, F f)
+{
+	auto count{ std::max(1u, std::thread::hardware_concurrency()) };
+	auto part{ (n + count - 1) / count };
+	auto t{ std::vector<std::thread>{} };
+	for (unsigned id{ 0 }; id < count; id++)
+	{
+		auto b{ std::min(n, id * part) };
+		auto e{ std::min(n, b + part) };
+		t.push_back(std::thread{ [=]() { f(id, b, e); } });
+	}
+	for (auto& _t : t) { _t.join(); }
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Parallel for and reduce demo" << std::endl;
+
+	{
+	auto v{ std::vector<int>(20) };
+	parallel::parallel_for(0, v.size(), [&](std::size_t i) { v[i] = i * i; });
+	std::cout << "squares: ";
+	for (auto i : v) { std::cout << i << " "; }
+	std::cout << std::endl;
+
+	auto sum{ parallel::parallel_reduce(v, 0l,
+		[](long a, long b) { return a + b; }) };
+	std::cout << "sum: " << sum << std::endl;
+
+	auto d{ std::vector<double>(1'000'000) };
+	for (std::size_t i{ 0 }; i < d.size(); i++) { d[i] = 1.0 / (i + 1); }
+	auto plus{ [](double a, double b) { return a + b; } };
+	auto options{ parallel::Options{ .deterministic = true } };
+	auto a{ parallel::parallel_reduce(d, 0.0, plus, options) };
+	auto b{ parallel::parallel_reduce(d, 0.0, plus, options) };
+	std::cout << "deterministic double sums are equal: "
+		<< (a == b ? "yes" : "no") << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 100'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n << " items, "
+		<< parallel::pool().concurrency() << " threads, ms" << std::endl;
+
+	auto data{ std::vector<int>(n) };
+	std::iota(data.begin(), data.end(), 0);
+	auto out{ std::vector<int>(n) };
+	using Histogram = std::array<long, 256>;
+
+	// Sum
+	auto manual_sum{ 0l };
+	auto manual_sum_ms{ measure([&]() {
+		auto parts{ std::vector<long>(std::thread::hardware_concurrency()
+			+ 1) };
+		thread_vector(n, [&](unsigned id, std::size_t b, std::size_t e) {
+			auto s{ 0l };
+			for (auto i{ b }; i < e; i++) { s += data[i]; }
+			parts[id] = s; });
+		for (auto p : parts) { manual_sum += p; } }) };
+	auto sum{ 0l };
+	auto sum_ms{ measure([&]() {
+		sum = parallel::parallel_reduce(data, 0l,
+			[](long a, long b) { return a + b; }); }) };
+
+	// Transform
+	auto transform{ [](int x) { return x * 3 + 1; } };
+	auto manual_transform_ms{ measure([&]() {
+		thread_vector(n, [&](unsigned, std::size_t b, std::size_t e) {
+			for (auto i{ b }; i < e; i++) { out[i] = transform(data[i]); }
+		}); }) };
+	auto transform_ms{ measure([&]() {
+		parallel::parallel_for(0, n, [&](std::size_t i) {
+			out[i] = transform(data[i]); }); }) };
+
+	// Histogram of the low bytes
+	auto manual_histogram{ Histogram{} };
+	auto manual_histogram_ms{ measure([&]() {
+		auto parts{ std::vector<Histogram>(
+			std::thread::hardware_concurrency() + 1) };
+		thread_vector(n, [&](unsigned id, std::size_t b, std::size_t e) {
+			auto h{ Histogram{} };
+			for (auto i{ b }; i < e; i++) { h[data[i] & 0xff]++; }
+			parts[id] = h; });
+		for (auto& p : parts)
+		{
+			for (int i{ 0 }; i < 256; i++) { manual_histogram[i] += p[i]; }
+		} }) };
+	auto histogram{ Histogram{} };
+	auto histogram_ms{ measure([&]() {
+		histogram = parallel::parallel_reduce(data, Histogram{},
+			[](Histogram& h, int x) { h[x & 0xff]++; },
+			[](Histogram a, const Histogram& b) {
+				for (int i{ 0 }; i < 256; i++) { a[i] += b[i]; }
+				return a; }); }) };
+
+	std::cout << "sum: thread vector: " << manual_sum_ms
+		<< " parallel_reduce: " << sum_ms << std::endl;
+	std::cout << "transform: thread vector: " << manual_transform_ms
+		<< " parallel_for: " << transform_ms << std::endl;
+	std::cout << "histogram: thread vector: " << manual_histogram_ms
+		<< " parallel_reduce: " << histogram_ms << std::endl;
+	std::cout << (sum == manual_sum && histogram == manual_histogram
+		? "results match" : "RESULTS DIFFER") << std::endl;
+	}
+
+	return 0;
+}
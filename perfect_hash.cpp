@@ -0,0 +1,369 @@
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <random>
+#include <chrono>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+// When all of the keys are known at compile time, the table may be built by
+// the compiler. A perfect hash function maps every key to its own slot, so a
+// lookup is one hash, one string comparison and no probing. The tables below
+// are constexpr: nothing is built at startup, they live in the read-only
+// data of the binary.
+
+/** \brief FNV-1a hash, usable at compile time */
+constexpr std::uint64_t string_hash(std::string_view s)
+{
+	auto h{ 0xcbf29ce484222325ull };
+	for (auto c : s)
+	{
+		h ^= static_cast<unsigned char>(c);
+		h *= 0x100000001b3ull;
+	}
+	return h;
+}
+
+/** \brief Mixes the seed into the string hash, so the low bits depend on
+ *         all of the bytes. The string is read only once per lookup. */
+constexpr std::uint64_t seeded_hash(std::uint64_t h, std::uint64_t seed)
+{
+	h ^= seed * 0x9e3779b97f4a7c15ull;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	return h;
+}
+
+/** \brief   Perfect hash function for N keys ("hash and displace")
+ *  \details Keys are spread into N buckets by the first hash. Then,
+ *           starting from the largest bucket, a seed is searched for every
+ *           bucket so that its keys fall into free slots of the table of
+ *           Slots entries. A lookup is bucket -> seed -> slot. */
+template<std::size_t N>
+class PerfectHash
+{
+	static_assert(N > 0, "the table needs at least one key");
+
+	public:
+		static constexpr std::size_t Slots{ std::bit_ceil(N) };
+
+		constexpr PerfectHash(const std::array<std::string_view, N>& keys)
+		{
+			auto hashes{ std::array<std::uint64_t, N>{} };
+			auto buckets{ std::array<std::size_t, N>{} };
+			auto sizes{ std::array<std::size_t, N>{} };
+			for (std::size_t i{ 0 }; i < N; i++)
+			{
+				hashes[i] = string_hash(keys[i]);
+				buckets[i] = seeded_hash(hashes[i], 0) % N;
+				sizes[buckets[i]]++;
+			}
+
+			// Keys with equal hashes get the same slot for every seed, so
+			// they are rejected before the search. At compile time the
+			// throw is an error.
+			auto sorted{ hashes };
+			std::sort(sorted.begin(), sorted.end());
+			if (std::adjacent_find(sorted.begin(), sorted.end())
+				!= sorted.end())
+			{
+				throw std::invalid_argument("duplicate keys");
+			}
+
+			auto order{ std::array<std::size_t, N>{} };
+			for (std::size_t b{ 0 }; b < N; b++) { order[b] = b; }
+			std::sort(order.begin(), order.end(),
+				[&](auto a, auto b) { return sizes[a] > sizes[b]; });
+
+			auto used{ std::array<bool, Slots>{} };
+			for (auto b : order)
+			{
+				if (sizes[b] == 0) { break; }
+				for (std::uint32_t seed{ 1 }; ; seed++)
+				{
+					auto taken{ std::array<std::size_t, N>{} };
+					auto count{ std::size_t{ 0 } };
+					auto ok{ true };
+					for (std::size_t i{ 0 }; i < N && ok; i++)
+					{
+						if (buckets[i] != b) { continue; }
+						auto s{ seeded_hash(hashes[i], seed) & (Slots - 1) };
+						ok = !used[s] && std::find(taken.begin(),
+							taken.begin() + count, s)
+							== taken.begin() + count;
+						taken[count++] = s;
+					}
+					if (!ok) { continue; }
+
+					seeds[b] = seed;
+					for (std::size_t i{ 0 }; i < N; i++)
+					{
+						if (buckets[i] != b) { continue; }
+						slot[i] = seeded_hash(hashes[i], seed)
+							& (Slots - 1);
+						used[slot[i]] = true;
+					}
+					break;
+				}
+			}
+		}
+
+		/** \brief Slot of the key, the key should be checked by caller */
+		constexpr std::size_t operator()(std::string_view key) const
+		{
+			auto h{ string_hash(key) };
+			return seeded_hash(h, seeds[seeded_hash(h, 0) % N])
+				& (Slots - 1);
+		}
+
+		/** \brief Slot of the i-th key given to the constructor */
+		std::array<std::size_t, N> slot{};
+
+	private:
+		std::array<std::uint32_t, N> seeds{};
+};
+
+/** \brief   Immutable string-keyed map built at compile time
+ *  \details Use make_static_map to deduce the size. Values should be
+ *           constexpr default constructible. */
+template<typename V, std::size_t N>
+class StaticMap
+{
+	using Hash = PerfectHash<N>;
+
+	public:
+		constexpr StaticMap(
+				const std::array<std::pair<std::string_view, V>, N>& items)
+			: hash(keys_of(items))
+		{
+			for (std::size_t i{ 0 }; i < N; i++)
+			{
+				keys[hash.slot[i]] = items[i].first;
+				values[hash.slot[i]] = items[i].second;
+				used[hash.slot[i]] = true;
+			}
+		}
+
+		/** \brief Pointer to the value or nullptr if there's no key */
+		constexpr const V* find(std::string_view key) const
+		{
+			auto s{ hash(key) };
+			return used[s] && keys[s] == key ? &values[s] : nullptr;
+		}
+
+		constexpr bool contains(std::string_view key) const
+		{
+			return find(key) != nullptr;
+		}
+
+		/** \brief Value of the key, throws std::out_of_range if absent */
+		constexpr const V& at(std::string_view key) const
+		{
+			auto v{ find(key) };
+			if (!v) { throw std::out_of_range("no such key"); }
+			return *v;
+		}
+
+		constexpr const V& operator[](std::string_view key) const
+		{
+			return at(key);
+		}
+
+		constexpr std::size_t size() const { return N; }
+
+	private:
+		static constexpr std::array<std::string_view, N> keys_of(
+				const std::array<std::pair<std::string_view, V>, N>& items)
+		{
+			auto k{ std::array<std::string_view, N>{} };
+			for (std::size_t i{ 0 }; i < N; i++) { k[i] = items[i].first; }
+			return k;
+		}
+
+		Hash hash;
+		std::array<std::string_view, Hash::Slots> keys{};
+		std::array<V, Hash::Slots> values{};
+		std::array<bool, Hash::Slots> used{};
+};
+
+/** \brief Immutable set of strings built at compile time */
+template<std::size_t N>
+class StaticSet
+{
+	using Hash = PerfectHash<N>;
+
+	public:
+		constexpr StaticSet(const std::array<std::string_view, N>& items)
+			: hash(items)
+		{
+			for (std::size_t i{ 0 }; i < N; i++)
+			{
+				keys[hash.slot[i]] = items[i];
+				used[hash.slot[i]] = true;
+			}
+		}
+
+		constexpr bool contains(std::string_view key) const
+		{
+			auto s{ hash(key) };
+			return used[s] && keys[s] == key;
+		}
+
+		constexpr std::size_t count(std::string_view key) const
+		{
+			return contains(key) ? 1 : 0;
+		}
+
+		constexpr std::size_t size() const { return N; }
+
+	private:
+		Hash hash;
+		std::array<std::string_view, Hash::Slots> keys{};
+		std::array<bool, Hash::Slots> used{};
+};
+
+template<typename V, std::size_t N>
+constexpr auto make_static_map(
+		const std::pair<std::string_view, V> (&items)[N])
+{
+	auto a{ std::array<std::pair<std::string_view, V>, N>{} };
+	std::copy(items, items + N, a.begin());
+	return StaticMap<V, N>(a);
+}
+
+template<std::size_t N>
+constexpr auto make_static_set(const std::string_view (&items)[N])
+{
+	auto a{ std::array<std::string_view, N>{} };
+	std::copy(items, items + N, a.begin());
+	return StaticSet<N>(a);
+}
+
+// The table is ready before main starts, the checks run in the compiler
+static constexpr auto demo_map{ make_static_map<int>({
+	{ "foo", 1 }, { "bar", 2 }, { "baz", 3 } }) };
+static_assert(demo_map.at("bar") == 2);
+static_assert(!demo_map.contains("xxx"));
+
+static constexpr auto keywords{ make_static_set({
+	"alignas", "alignof", "auto", "bool", "break", "case", "catch",
+	"char", "class", "concept", "const", "consteval", "constexpr",
+	"constinit", "continue", "co_await", "co_return", "co_yield",
+	"decltype", "default", "delete", "do", "double", "else", "enum",
+	"explicit", "export", "extern", "false", "float", "for", "friend",
+	"goto", "if", "inline", "int", "long", "mutable", "namespace",
+	"new", "noexcept", "nullptr", "operator", "private", "protected",
+	"public", "register", "requires", "return", "short", "signed",
+	"sizeof", "static", "struct", "switch", "template", "this",
+	"throw", "true", "try", "typedef", "typename", "union",
+	"unsigned", "using", "virtual", "void", "volatile", "while" }) };
+static_assert(keywords.contains("constexpr"));
+static_assert(!keywords.contains("constexp"));
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Compile-time perfect hash demo" << std::endl;
+
+	{
+	std::cout << "accessing items: " << demo_map["foo"] << std::endl;
+	std::cout << "checks if the map has an item: "
+		<< demo_map.contains("baz") << " " << demo_map.contains("xxx")
+		<< std::endl;
+	std::cout << "getting inexistent items: ";
+	try { demo_map.at("xxx"); }
+	catch (const std::out_of_range& e) { std::cout << e.what(); }
+	std::cout << std::endl;
+	std::cout << "set of " << keywords.size() << " keywords: "
+		<< "'while' " << keywords.count("while") << ", "
+		<< "'whale' " << keywords.count("whale") << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n << " lookups, ms"
+		<< std::endl;
+
+	auto words{ std::vector<std::string>{
+		"alignas", "alignof", "auto", "bool", "break", "case", "catch",
+		"char", "class", "concept", "const", "consteval", "constexpr",
+		"constinit", "continue", "co_await", "co_return", "co_yield",
+		"decltype", "default", "delete", "do", "double", "else", "enum",
+		"explicit", "export", "extern", "false", "float", "for",
+		"friend", "goto", "if", "inline", "int", "long", "mutable",
+		"namespace", "new", "noexcept", "nullptr", "operator",
+		"private", "protected", "public", "register", "requires",
+		"return", "short", "signed", "sizeof", "static", "struct",
+		"switch", "template", "this", "throw", "true", "try",
+		"typedef", "typename", "union", "unsigned", "using", "virtual",
+		"void", "volatile", "while" } };
+
+	// Startup: the standard containers are filled at runtime
+	// Transparent comparators, so the lookups don't build a std::string
+	struct Hash
+	{
+		using is_transparent = void;
+		std::size_t operator()(std::string_view s) const
+		{
+			return std::hash<std::string_view>{}(s);
+		}
+	};
+	auto tree{ std::map<std::string, int, std::less<>>{} };
+	auto tree_ms{ measure([&]() {
+		for (auto& w : words) { tree[w] = 1; } }) };
+	auto hash{ std::unordered_map<std::string, int, Hash,
+		std::equal_to<>>{} };
+	auto hash_ms{ measure([&]() {
+		for (auto& w : words) { hash[w] = 1; } }) };
+	std::cout << "building " << words.size() << " keys:"
+		<< " std::map: " << tree_ms
+		<< " std::unordered_map: " << hash_ms
+		<< " StaticSet: 0 (built by the compiler)" << std::endl;
+
+	// Queries are a mix of keywords and identifiers
+	auto rng{ std::mt19937{ 42 } };
+	auto queries{ std::vector<std::string_view>{} };
+	auto misses{ std::vector<std::string>{ "x", "value", "index",
+		"counter", "whale", "constexp", "integer", "buffer" } };
+	for (std::size_t i{ 0 }; i < n; i++)
+	{
+		queries.push_back(rng() % 2 ? std::string_view(
+			words[rng() % words.size()])
+			: std::string_view(misses[rng() % misses.size()]));
+	}
+
+	auto a{ 0l }, b{ 0l }, c{ 0l };
+	auto tree_lookup{ measure([&]() {
+		for (auto q : queries) { a += tree.contains(q); } }) };
+	auto hash_lookup{ measure([&]() {
+		for (auto q : queries) { b += hash.contains(q); } }) };
+	auto static_lookup{ measure([&]() {
+		for (auto q : queries) { c += keywords.contains(q); } }) };
+
+	std::cout << "lookups:"
+		<< " std::map: " << tree_lookup
+		<< " std::unordered_map: " << hash_lookup
+		<< " StaticSet: " << static_lookup << std::endl;
+	std::cout << (a == b && b == c ? "results match" : "RESULTS DIFFER")
+		<< std::endl;
+	}
+
+	return 0;
+}
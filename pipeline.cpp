@@ -0,0 +1,387 @@
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <array>
+#include <tuple>
+#include <string>
+#include <chrono>
+#include <ranges>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+// std::views adaptors are lazy, but every stage wraps the iterator of the
+// previous one, so each element goes through a chain of iterator increments,
+// comparisons and dereferences. The pipeline below fuses the stages into a
+// single loop: the source is read in chunks of 256 items, every stage
+// processes the whole chunk into a buffer on the stack and passes it to the
+// next stage. Nothing is allocated except the output of collect().
+namespace fused
+{
+	constexpr std::size_t chunk_size{ 256 };
+
+	/** \brief Keeps the items matching the predicate */
+	template<typename P>
+	struct Filter
+	{
+		template<typename In> using output = In;
+
+		std::size_t bound(std::size_t n) const { return n; }
+
+		template<typename In>
+		std::size_t apply(const In* in, std::size_t n, In* out)
+		{
+			auto m{ std::size_t{ 0 } };
+			for (std::size_t i{ 0 }; i < n; i++)
+			{
+				// Branchless: the item is always written, but
+				// the position moves only if it matches
+				out[m] = in[i];
+				m += std::invoke(pred, in[i]) ? 1 : 0;
+			}
+			return m;
+		}
+
+		bool done() const { return false; }
+
+		P pred;
+	};
+
+	/** \brief Converts every item with the function */
+	template<typename F>
+	struct Transform
+	{
+		template<typename In> using output =
+			std::remove_cvref_t<std::invoke_result_t<F&, const In&>>;
+
+		std::size_t bound(std::size_t n) const { return n; }
+
+		template<typename In>
+		std::size_t apply(const In* in, std::size_t n, output<In>* out)
+		{
+			for (std::size_t i{ 0 }; i < n; i++)
+			{
+				out[i] = std::invoke(func, in[i]);
+			}
+			return n;
+		}
+
+		bool done() const { return false; }
+
+		F func;
+	};
+
+	/** \brief Passes the first count items and stops the pipeline */
+	struct Take
+	{
+		template<typename In> using output = In;
+
+		std::size_t bound(std::size_t n) const { return std::min(n, count); }
+
+		template<typename In>
+		std::size_t apply(const In* in, std::size_t n, In* out)
+		{
+			auto m{ std::min(n, count) };
+			std::copy_n(in, m, out);
+			count -= m;
+			return m;
+		}
+
+		bool done() const { return count == 0; }
+
+		std::size_t count;
+	};
+
+	/** \brief Skips the first count items */
+	struct Drop
+	{
+		template<typename In> using output = In;
+
+		std::size_t bound(std::size_t n) const
+		{
+			return n > count ? n - count : 0;
+		}
+
+		template<typename In>
+		std::size_t apply(const In* in, std::size_t n, In* out)
+		{
+			auto skip{ std::min(n, count) };
+			count -= skip;
+			std::copy(in + skip, in + n, out);
+			return n - skip;
+		}
+
+		bool done() const { return false; }
+
+		std::size_t count;
+	};
+
+	template<typename P> Filter<P> filter(P pred) { return { pred }; }
+	template<typename F> Transform<F> transform(F func) { return { func }; }
+	inline Take take(std::size_t count) { return { count }; }
+	inline Drop drop(std::size_t count) { return { count }; }
+
+	/** \brief Terminal tag, makes std::vector of the pipeline output */
+	struct Collect {};
+	inline Collect collect() { return {}; }
+
+	/** \brief   Chain of stages bound to the source range
+	 *  \details The source is referenced, not copied, so it should outlive
+	 *           the pipeline. Items produced by the stages should be
+	 *           default constructible, as they're stored in chunk
+	 *           buffers. */
+	template<typename R, typename... Stages>
+	class Pipeline
+	{
+		using source_type = std::ranges::range_value_t<R>;
+
+		template<std::size_t I, typename In>
+		struct output_of
+		{
+			using type = typename output_of<I + 1,
+				typename std::tuple_element_t<I,
+					std::tuple<Stages...>>::template output<In>
+				>::type;
+		};
+
+		template<typename In>
+		struct output_of<sizeof...(Stages), In> { using type = In; };
+
+		public:
+			using value_type = typename output_of<0, source_type>::type;
+
+			Pipeline(R& source, std::tuple<Stages...> stages)
+				: source(source), stages(stages) {}
+
+			/** \brief Appends one more stage */
+			template<typename S>
+			Pipeline<R, Stages..., S> operator|(S stage) const
+			{
+				return { source, std::tuple_cat(stages,
+					std::make_tuple(stage)) };
+			}
+
+			/** \brief   Upper bound of the number of output items
+			 *  \details It's exact when there are no filters */
+			std::size_t size_bound() const
+			{
+				auto n{ std::size_t(std::ranges::size(source)) };
+				std::apply([&](auto&... s) { ((n = s.bound(n)), ...); },
+					stages);
+				return n;
+			}
+
+			/** \brief Calls f with every output chunk as (pointer, size) */
+			template<typename F>
+			void for_each_chunk(F&& f) const
+			{
+				// Stages have counters, so every run gets a copy
+				auto s{ stages };
+				auto n{ std::size_t(std::ranges::size(source)) };
+				std::array<source_type, chunk_size> buffer;
+				auto it{ std::ranges::begin(source) };
+
+				for (std::size_t pos{ 0 }; pos < n; pos += chunk_size)
+				{
+					auto m{ std::min(chunk_size, n - pos) };
+					const source_type* in;
+					if constexpr (std::ranges::contiguous_range<R>)
+					{
+						in = std::ranges::data(source) + pos;
+					}
+					else
+					{
+						for (std::size_t i{ 0 }; i < m; i++, ++it)
+						{
+							buffer[i] = *it;
+						}
+						in = buffer.data();
+					}
+
+					run<0>(s, in, m, f);
+
+					auto stop{ std::apply([](auto&... st) {
+						return (false || ... || st.done()); }, s) };
+					if (stop) { break; }
+				}
+			}
+
+			/** \brief Calls f with every output item */
+			template<typename F>
+			void for_each(F&& f) const
+			{
+				for_each_chunk(
+					[&](const value_type* p, std::size_t n)
+					{
+						for (std::size_t i{ 0 }; i < n; i++)
+						{
+							f(p[i]);
+						}
+					});
+			}
+
+			/** \brief Folds the output items with op */
+			template<typename T, typename Op>
+			T reduce(T init, Op op) const
+			{
+				for_each_chunk(
+					[&](const value_type* p, std::size_t n)
+					{
+						for (std::size_t i{ 0 }; i < n; i++)
+						{
+							init = op(init, p[i]);
+						}
+					});
+				return init;
+			}
+
+			/** \brief   Makes a vector of the output items
+			 *  \details Capacity is reserved once from size_bound(),
+			 *           so the vector is never reallocated */
+			std::vector<value_type> operator|(Collect) const
+			{
+				auto v{ std::vector<value_type>() };
+				v.reserve(size_bound());
+				for_each_chunk(
+					[&](const value_type* p, std::size_t n)
+					{
+						v.insert(v.end(), p, p + n);
+					});
+				return v;
+			}
+
+		private:
+			template<std::size_t I, typename In, typename F>
+			static void run(std::tuple<Stages...>& s, const In* in,
+					std::size_t n, F& f)
+			{
+				if constexpr (I == sizeof...(Stages))
+				{
+					f(in, n);
+				}
+				else
+				{
+					auto& stage{ std::get<I>(s) };
+					using Out = typename std::remove_cvref_t<
+						decltype(stage)>::template output<In>;
+					// Left uninitialized, the stage overwrites it
+					std::array<Out, chunk_size> out;
+					auto m{ stage.apply(in, n, out.data()) };
+					if (m) { run<I + 1>(s, out.data(), m, f); }
+				}
+			}
+
+			R& source;
+			std::tuple<Stages...> stages;
+	};
+
+	/** \brief Starts the pipeline over the sized range */
+	template<std::ranges::sized_range R>
+	Pipeline<R> from(R& source) { return { source, {} }; }
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Fused pipeline demo" << std::endl;
+
+	auto x{ std::deque<int>{ 1, 2, 3, 4, 5 } };
+	auto even{ [](int v) -> bool { return v % 2 == 0; } };
+
+	{
+	std::cout << "iterating with a first 3 items: ";
+	(fused::from(x) | fused::take(3))
+		.for_each([](int i) { std::cout << i << " "; });
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "iterating skipping first 3 items: ";
+	(fused::from(x) | fused::drop(3))
+		.for_each([](int i) { std::cout << i << " "; });
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "iterating through the items by criteria: ";
+	(fused::from(x) | fused::filter(even))
+		.for_each([](int i) { std::cout << i << " "; });
+	std::cout << std::endl;
+	}
+
+	{
+	std::cout << "collecting the combination to the vector: ";
+	auto y{ fused::from(x)
+		| fused::drop(1)
+		| fused::transform([](int v) -> double { return v * 1.5; })
+		| fused::take(3)
+		| fused::collect() };
+	for (auto i : y) { std::cout << i << " "; }
+	std::cout << "(capacity " << y.capacity() << ")" << std::endl;
+	}
+
+	{
+	// Element count may be passed as the first argument
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 10'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n << " items, ms"
+		<< std::endl;
+
+	auto v{ std::vector<int>(n) };
+	std::iota(v.begin(), v.end(), 0);
+	auto square{ [](int i) -> long { return long(i) * i; } };
+	auto small{ [](long i) -> bool { return i % 3 != 0; } };
+	// The sums of squares overflow long, unsigned wraps around instead
+	auto sink{ std::uint64_t{ 0 } };
+
+	{
+	auto views{ measure([&]() {
+		for (auto i : v | std::views::filter(even)
+				| std::views::transform(square)
+				| std::views::filter(small))
+		{ sink += i; } }) };
+	auto fusion{ measure([&]() {
+		sink += (fused::from(v)
+			| fused::filter(even)
+			| fused::transform(square)
+			| fused::filter(small))
+			.reduce(std::uint64_t{ 0 }, std::plus<>{}); }) };
+	std::cout << "filter | transform | filter, sum:"
+		<< " std::views: " << views
+		<< " fused: " << fusion << std::endl;
+	}
+
+	{
+	auto views{ measure([&]() {
+		auto r{ v | std::views::drop(n / 4)
+			| std::views::transform(square)
+			| std::views::take(n / 2) };
+		auto out{ std::vector<long>() };
+		std::ranges::copy(r, std::back_inserter(out));
+		sink += out.size(); }) };
+	auto fusion{ measure([&]() {
+		auto out{ fused::from(v)
+			| fused::drop(n / 4)
+			| fused::transform(square)
+			| fused::take(n / 2)
+			| fused::collect() };
+		sink += out.size(); }) };
+	std::cout << "drop | transform | take, collect:"
+		<< " std::views: " << views
+		<< " fused: " << fusion << std::endl;
+	}
+
+	std::cout << "checksum: " << sink << std::endl;
+	}
+
+	return 0;
+}
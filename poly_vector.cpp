@@ -0,0 +1,418 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <any>
+#include <string>
+#include <random>
+#include <chrono>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+/** \brief   Vector of objects of different types in one buffer
+ *  \details Every item is a record: a header with the pointer to the
+ *           table of operations of its type (like a vtable pointer) and the
+ *           offsets of the object and of the next record, then the object.
+ *           Records follow each other, so adding an item is not an
+ *           allocation and iterating is a walk through contiguous memory.
+ *           The items are moved when the buffer grows, the references are
+ *           valid until the next emplace_back.
+ *  \tparam  Base If not void, every item should derive from Base, and
+ *           for_each passes items as Base& */
+template<typename Base = void>
+class PolyVector
+{
+	// Table of operations, one static instance per item type
+	struct Operations
+	{
+		void (*destroy)(void* object);
+		void (*relocate)(void* to, void* from);
+	};
+
+	template<typename T>
+	static constexpr Operations operations_for{
+		std::is_trivially_destructible_v<T> ? nullptr
+			: +[](void* object) -> void
+			{
+				std::destroy_at(static_cast<T*>(object));
+			},
+		+[](void* to, void* from) -> void
+		{
+			std::construct_at(static_cast<T*>(to),
+				std::move(*static_cast<T*>(from)));
+			std::destroy_at(static_cast<T*>(from));
+		}
+	};
+
+	struct Header
+	{
+		const Operations* ops;
+		std::uint32_t next;   // Offset of the next record
+		std::uint16_t object; // Offset of the object
+		std::uint16_t base;   // Offset of the Base subobject
+	};
+
+	// The buffer is aligned like this, so the records keep their
+	// alignment when they're moved into the bigger buffer
+	static constexpr std::size_t Align{ 64 };
+
+	static constexpr std::size_t align_up(std::size_t n, std::size_t a)
+	{
+		return (n + a - 1) & ~(a - 1);
+	}
+
+	public:
+		/** \brief Item without the static type, see for_each */
+		class Ref
+		{
+			public:
+				template<typename T>
+				bool holds() const { return ops == &operations_for<T>; }
+
+				/** \brief Pointer to the item or nullptr if it's not T */
+				template<typename T>
+				T* get_if() const
+				{
+					return holds<T>() ? static_cast<T*>(object) : nullptr;
+				}
+
+			private:
+				friend PolyVector;
+				Ref(const Operations* ops, void* object)
+					: ops(ops), object(object) {}
+
+				const Operations* ops;
+				void* object;
+		};
+
+		PolyVector() = default;
+		PolyVector(const PolyVector&) = delete;
+		PolyVector& operator=(const PolyVector&) = delete;
+
+		PolyVector(PolyVector&& obj) noexcept
+			: data(std::exchange(obj.data, nullptr)),
+			  used(std::exchange(obj.used, 0)),
+			  capacity(std::exchange(obj.capacity, 0)),
+			  count(std::exchange(obj.count, 0)) {}
+
+		PolyVector& operator=(PolyVector&& obj) noexcept
+		{
+			if (this != &obj)
+			{
+				release();
+				data = std::exchange(obj.data, nullptr);
+				used = std::exchange(obj.used, 0);
+				capacity = std::exchange(obj.capacity, 0);
+				count = std::exchange(obj.count, 0);
+			}
+			return *this;
+		}
+
+		~PolyVector() { release(); }
+
+		/** \brief Constructs T at the end of the buffer */
+		template<typename T, typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			static_assert(std::is_void_v<Base>
+				|| std::is_base_of_v<Base, T>, "T should derive from Base");
+			static_assert(alignof(T) <= Align, "over-aligned type");
+			static_assert(sizeof(T) < 65536 - Align,
+				"offsets in the header are 16-bit");
+			static_assert(std::is_nothrow_move_constructible_v<T>,
+				"items are moved when the buffer grows");
+
+			// The offset depends on the position, records are aligned
+			// like the header only
+			auto object{ align_up(used + sizeof(Header), alignof(T)) - used };
+			auto size{ align_up(object + sizeof(T), alignof(Header)) };
+			reserve_bytes(used + size);
+
+			auto record{ data + used };
+			auto p{ std::construct_at(reinterpret_cast<T*>(record + object),
+				std::forward<Args>(args)...) };
+			auto base{ object };
+			if constexpr (!std::is_void_v<Base>)
+			{
+				base = reinterpret_cast<std::byte*>(static_cast<Base*>(p))
+					- record;
+			}
+			std::construct_at(reinterpret_cast<Header*>(record), Header{
+				&operations_for<T>, std::uint32_t(size),
+				std::uint16_t(object), std::uint16_t(base) });
+
+			used += size;
+			count++;
+			return *p;
+		}
+
+		template<typename T>
+		void push_back(T&& value)
+		{
+			emplace_back<std::remove_cvref_t<T>>(std::forward<T>(value));
+		}
+
+		/** \brief   Calls f for every item
+		 *  \details f gets Base& if there's a Base, Ref otherwise */
+		template<typename F>
+		void for_each(F&& f)
+		{
+			for (std::size_t at{ 0 }; at < used; )
+			{
+				auto record{ data + at };
+				auto h{ header(record) };
+				if constexpr (std::is_void_v<Base>)
+				{
+					f(Ref(h->ops, record + h->object));
+				}
+				else
+				{
+					f(*std::launder(reinterpret_cast<Base*>(
+						record + h->base)));
+				}
+				at += h->next;
+			}
+		}
+
+		/** \brief   Calls f with the item of its own type
+		 *  \details The type is found by comparing the operations pointer
+		 *           with the ones of Ts, so the calls are direct and may be
+		 *           inlined. Items of other types are skipped. */
+		template<typename... Ts, typename F>
+		void visit(F&& f)
+		{
+			for (std::size_t at{ 0 }; at < used; )
+			{
+				auto record{ data + at };
+				auto h{ header(record) };
+				auto object{ record + h->object };
+				(void)((h->ops == &operations_for<Ts>
+					&& (f(*std::launder(reinterpret_cast<Ts*>(object))),
+						true)) || ...);
+				at += h->next;
+			}
+		}
+
+		std::size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		/** \brief Bytes used by the records, with the headers */
+		std::size_t bytes() const { return used; }
+
+		void reserve_bytes(std::size_t n)
+		{
+			if (n <= capacity) { return; }
+			auto new_capacity{ std::max(n, capacity * 2) };
+			auto new_data{ static_cast<std::byte*>(::operator new(
+				new_capacity, std::align_val_t{ Align })) };
+
+			// Records keep their offsets, the objects are moved
+			for (std::size_t at{ 0 }; at < used; )
+			{
+				auto h{ header(data + at) };
+				std::memcpy(new_data + at, h, sizeof(Header));
+				h->ops->relocate(new_data + at + h->object,
+					data + at + h->object);
+				at += h->next;
+			}
+
+			::operator delete(data, std::align_val_t{ Align });
+			data = new_data;
+			capacity = new_capacity;
+		}
+
+		void clear()
+		{
+			for (std::size_t at{ 0 }; at < used; )
+			{
+				auto h{ header(data + at) };
+				if (h->ops->destroy)
+				{
+					h->ops->destroy(data + at + h->object);
+				}
+				at += h->next;
+			}
+			used = 0;
+			count = 0;
+		}
+
+	private:
+		static Header* header(std::byte* record)
+		{
+			return std::launder(reinterpret_cast<Header*>(record));
+		}
+
+		void release()
+		{
+			clear();
+			::operator delete(data, std::align_val_t{ Align });
+			data = nullptr;
+			capacity = 0;
+		}
+
+		std::byte* data{ nullptr };
+		std::size_t used{ 0 };
+		std::size_t capacity{ 0 };
+		std::size_t count{ 0 };
+};
+
+struct Shape
+{
+	virtual ~Shape() = default;
+	virtual double area() const = 0;
+};
+
+struct Circle final : Shape
+{
+	Circle(double r) : r(r) {}
+	double area() const override { return 3.14159265 * r * r; }
+	double r;
+};
+
+struct Square final : Shape
+{
+	Square(double a) : a(a) {}
+	double area() const override { return a * a; }
+	double a;
+};
+
+struct Rectangle final : Shape
+{
+	Rectangle(double w, double h) : w(w), h(h) {}
+	double area() const override { return w * h; }
+	double w, h;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Heterogeneous contiguous vector demo" << std::endl;
+
+	{
+	// Arguments of a log line, collected at runtime
+	auto args{ PolyVector<>{} };
+	args.push_back(42);
+	args.push_back(std::string("foo"));
+	args.push_back(3.14);
+	args.push_back('c');
+
+	std::cout << "visiting known types: ";
+	args.visit<int, double, std::string>(
+		[](auto& v) { std::cout << v << " "; });
+	std::cout << std::endl;
+
+	std::cout << "checking types: ";
+	args.for_each([](auto item) {
+		std::cout << (item.template holds<char>() ? "char " : "- "); });
+	std::cout << std::endl;
+	std::cout << args.size() << " items in " << args.bytes() << " bytes"
+		<< std::endl;
+	}
+
+	{
+	auto shapes{ PolyVector<Shape>{} };
+	shapes.emplace_back<Circle>(1.0);
+	shapes.emplace_back<Square>(2.0);
+	shapes.emplace_back<Rectangle>(2.0, 3.0);
+	std::cout << "areas through the base class: ";
+	shapes.for_each([](Shape& s) { std::cout << s.area() << " "; });
+	std::cout << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n
+		<< " shapes, build + sum of areas, ms" << std::endl;
+
+	auto rng{ std::mt19937{ 42 } };
+	auto kinds{ std::vector<int>(n) };
+	for (auto& k : kinds) { k = rng() % 3; }
+
+	auto a{ 0.0 }, b{ 0.0 }, c{ 0.0 }, d{ 0.0 };
+
+	auto pointers{ std::vector<std::unique_ptr<Shape>>{} };
+	auto ptr_build{ measure([&]() {
+		pointers.reserve(n);
+		for (std::size_t i{ 0 }; i < n; i++)
+		{
+			switch (kinds[i])
+			{
+				case 0: pointers.push_back(
+					std::make_unique<Circle>(1.0)); break;
+				case 1: pointers.push_back(
+					std::make_unique<Square>(2.0)); break;
+				case 2: pointers.push_back(
+					std::make_unique<Rectangle>(2.0, 3.0)); break;
+			}
+		} }) };
+	auto ptr_sum{ measure([&]() {
+		for (auto& s : pointers) { a += s->area(); } }) };
+
+	auto anys{ std::vector<std::any>{} };
+	auto any_build{ measure([&]() {
+		anys.reserve(n);
+		for (std::size_t i{ 0 }; i < n; i++)
+		{
+			switch (kinds[i])
+			{
+				case 0: anys.emplace_back(Circle(1.0)); break;
+				case 1: anys.emplace_back(Square(2.0)); break;
+				case 2: anys.emplace_back(Rectangle(2.0, 3.0)); break;
+			}
+		} }) };
+	auto any_sum{ measure([&]() {
+		for (auto& s : anys)
+		{
+			if (auto p{ std::any_cast<Circle>(&s) }) { b += p->area(); }
+			else if (auto p{ std::any_cast<Square>(&s) }) { b += p->area(); }
+			else if (auto p{ std::any_cast<Rectangle>(&s) })
+			{
+				b += p->area();
+			}
+		} }) };
+
+	auto poly{ PolyVector<Shape>{} };
+	auto poly_build{ measure([&]() {
+		// 16 bytes of the header and the biggest shape
+		poly.reserve_bytes(n * (16 + sizeof(Rectangle)));
+		for (std::size_t i{ 0 }; i < n; i++)
+		{
+			switch (kinds[i])
+			{
+				case 0: poly.emplace_back<Circle>(1.0); break;
+				case 1: poly.emplace_back<Square>(2.0); break;
+				case 2: poly.emplace_back<Rectangle>(2.0, 3.0); break;
+			}
+		} }) };
+	auto poly_sum{ measure([&]() {
+		poly.for_each([&](Shape& s) { c += s.area(); }); }) };
+	auto visit_sum{ measure([&]() {
+		poly.visit<Circle, Square, Rectangle>(
+			[&](auto& s) { d += s.area(); }); }) };
+
+	std::cout << "std::vector<std::unique_ptr<Shape>>:"
+		<< " build " << ptr_build << " sum " << ptr_sum << std::endl;
+	std::cout << "std::vector<std::any>:"
+		<< " build " << any_build << " sum " << any_sum << std::endl;
+	std::cout << "PolyVector<Shape>:"
+		<< " build " << poly_build << " sum (virtual) " << poly_sum
+		<< " sum (visit) " << visit_sum
+		<< " (" << poly.bytes() << " bytes)" << std::endl;
+	std::cout << (a == b && b == c && c == d ? "sums match" : "SUMS DIFFER")
+		<< std::endl;
+	}
+
+	return 0;
+}
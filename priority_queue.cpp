@@ -0,0 +1,433 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+// std::priority_queue is a binary heap: every level is a cache miss once the
+// heap is bigger than the cache, and an item can't be found to change its
+// priority. A heap with 4 children per node is half as deep, and the 4
+// children share a cache line. Under a mutex all of the threads wait for the
+// one top, so the concurrent queue keeps many heaps and gives up the strict
+// order: a pop takes the better top of two random heaps.
+
+/** \brief   d-ary heap with handles for decrease_key and erase
+ *  \details The top is the smallest item by default, like the nearest
+ *           deadline or the shortest distance. Every item gets a handle
+ *           that stays valid until the item leaves the heap, the heap
+ *           keeps the position of every handle up to date. */
+template<typename T, std::size_t D = 4, typename Compare = std::greater<T>>
+class DaryHeap
+{
+	static_assert(D >= 2);
+	static constexpr std::uint32_t Nil{
+		std::numeric_limits<std::uint32_t>::max() };
+
+	public:
+		using Handle = std::uint32_t;
+
+		bool empty() const { return items.empty(); }
+
+		std::size_t size() const { return items.size(); }
+
+		const T& top() const { return items.front().value; }
+
+		/** \brief True while the item of the handle is in the heap */
+		bool contains(Handle h) const
+		{
+			return h < positions.size() && positions[h] != Nil;
+		}
+
+		const T& operator[](Handle h) const
+		{
+			return items[positions[h]].value;
+		}
+
+		Handle push(T value)
+		{
+			auto h{ Handle{} };
+			if (free.empty())
+			{
+				h = positions.size();
+				positions.push_back(Nil);
+			}
+			else
+			{
+				h = free.back();
+				free.pop_back();
+			}
+			items.push_back({ std::move(value), h });
+			positions[h] = items.size() - 1;
+			sift_up(items.size() - 1);
+			return h;
+		}
+
+		T pop()
+		{
+			auto value{ std::move(items.front().value) };
+			remove(0);
+			return value;
+		}
+
+		/** \brief Moves the item closer to the top, the new value must not
+		 *         be worse than the old one */
+		void decrease_key(Handle h, T value)
+		{
+			auto i{ positions[h] };
+			items[i].value = std::move(value);
+			sift_up(i);
+		}
+
+		/** \brief Changes the item in any direction */
+		void update(Handle h, T value)
+		{
+			auto i{ positions[h] };
+			items[i].value = std::move(value);
+			sift_down(sift_up(i));
+		}
+
+		void erase(Handle h) { remove(positions[h]); }
+
+	private:
+		struct Item
+		{
+			T value;
+			Handle handle;
+		};
+
+		// True if a goes above b
+		bool above(const Item& a, const Item& b) const
+		{
+			return compare(b.value, a.value);
+		}
+
+		void place(std::size_t i, Item&& item)
+		{
+			positions[item.handle] = i;
+			items[i] = std::move(item);
+		}
+
+		// The item is moved once: the hole goes up, the item is placed last
+		std::size_t sift_up(std::size_t i)
+		{
+			auto item{ std::move(items[i]) };
+			while (i > 0)
+			{
+				auto parent{ (i - 1) / D };
+				if (!above(item, items[parent])) { break; }
+				place(i, std::move(items[parent]));
+				i = parent;
+			}
+			place(i, std::move(item));
+			return i;
+		}
+
+		std::size_t sift_down(std::size_t i)
+		{
+			auto item{ std::move(items[i]) };
+			while (true)
+			{
+				auto first{ i * D + 1 };
+				if (first >= items.size()) { break; }
+				auto last{ std::min(first + D, items.size()) };
+				auto best{ first };
+				for (auto c{ first + 1 }; c < last; c++)
+				{
+					if (above(items[c], items[best])) { best = c; }
+				}
+				if (!above(items[best], item)) { break; }
+				place(i, std::move(items[best]));
+				i = best;
+			}
+			place(i, std::move(item));
+			return i;
+		}
+
+		void remove(std::size_t i)
+		{
+			auto h{ items[i].handle };
+			positions[h] = Nil;
+			free.push_back(h);
+			if (i + 1 < items.size())
+			{
+				place(i, std::move(items.back()));
+				items.pop_back();
+				sift_down(sift_up(i));
+			}
+			else
+			{
+				items.pop_back();
+			}
+		}
+
+		std::vector<Item> items;
+		std::vector<std::uint32_t> positions;  // Handle -> index in items
+		std::vector<Handle> free;
+		[[no_unique_address]] Compare compare;
+};
+
+/** \brief   Relaxed concurrent priority queue (MultiQueue)
+ *  \details Keeps Factor heaps per thread, each under its own lock. push
+ *           goes to a random heap, pop compares the tops of two random heaps
+ *           and takes the better one. The threads rarely meet on one lock,
+ *           and the popped item is close to the best one: on average among
+ *           the best Factor * threads items. pop returns nothing only if
+ *           all of the heaps are empty. */
+template<typename T, typename Compare = std::greater<T>, std::size_t Factor = 2>
+class MultiQueue
+{
+	public:
+		explicit MultiQueue(
+			unsigned threads = std::thread::hardware_concurrency())
+			: count(std::max(2u, threads * unsigned(Factor))),
+			  heaps(std::make_unique<Heap[]>(count))
+		{
+		}
+
+		void push(T value)
+		{
+			while (true)
+			{
+				auto& heap{ heaps[random() % count] };
+				auto lock{ std::unique_lock(heap.m, std::try_to_lock) };
+				if (!lock) { continue; }
+				heap.items.push(std::move(value));
+				heap.size.store(heap.items.size(), std::memory_order_relaxed);
+				return;
+			}
+		}
+
+		std::optional<T> pop()
+		{
+			// A few tries with random heaps, then a scan to be sure that
+			// everything is empty
+			for (int attempt{ 0 }; attempt < 16; attempt++)
+			{
+				auto& a{ heaps[random() % count] };
+				auto& b{ heaps[random() % count] };
+				auto lock_a{ std::unique_lock(a.m, std::try_to_lock) };
+				if (!lock_a) { continue; }
+				auto lock_b{ &a == &b ? std::unique_lock<std::mutex>{}
+					: std::unique_lock(b.m, std::try_to_lock) };
+				auto* best{ a.items.empty() ? nullptr : &a };
+				if (lock_b && !b.items.empty() && (!best
+					|| compare(a.items.top(), b.items.top())))
+				{
+					best = &b;
+				}
+				if (best) { return take(*best); }
+			}
+			for (std::size_t i{ 0 }; i < count; i++)
+			{
+				if (heaps[i].size.load(std::memory_order_relaxed) == 0)
+				{
+					continue;
+				}
+				auto lock{ std::lock_guard(heaps[i].m) };
+				if (!heaps[i].items.empty()) { return take(heaps[i]); }
+			}
+			return std::nullopt;
+		}
+
+	private:
+		struct alignas(64) Heap
+		{
+			std::mutex m;
+			std::priority_queue<T, std::vector<T>, Compare> items;
+			std::atomic<std::size_t> size{ 0 };
+		};
+
+		static T take(Heap& heap)
+		{
+			auto value{ heap.items.top() };
+			heap.items.pop();
+			heap.size.store(heap.items.size(), std::memory_order_relaxed);
+			return value;
+		}
+
+		static std::uint64_t random()
+		{
+			// xorshift, one state per thread
+			thread_local std::uint64_t state{ std::hash<std::thread::id>{}(
+				std::this_thread::get_id()) | 1 };
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			return state;
+		}
+
+		std::size_t count;
+		std::unique_ptr<Heap[]> heaps;
+		[[no_unique_address]] Compare compare;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Priority queue demo" << std::endl;
+
+	{
+	auto heap{ DaryHeap<int>{} };
+	for (auto i : { 50, 20, 80, 10, 70 }) { heap.push(i); }
+	auto h{ heap.push(90) };
+	heap.decrease_key(h, 5);
+	std::cout << "d-ary heap, 90 decreased to 5: ";
+	while (!heap.empty()) { std::cout << heap.pop() << " "; }
+	std::cout << std::endl;
+
+	auto q{ MultiQueue<int>(2) };
+	for (auto i : { 50, 20, 80, 10, 70, 90 }) { q.push(i); }
+	std::cout << "multi-queue, roughly ordered: ";
+	while (auto i{ q.pop() }) { std::cout << *i << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	auto generator{ std::mt19937_64{ 42 } };
+
+	// Shortest paths on a random graph: the d-ary heap updates the
+	// distance in place, the standard heap gets a duplicate every time and
+	// skips the stale ones
+	std::cout << std::endl << "Benchmark, Dijkstra on " << n
+		<< " vertices with 8 edges each, ms" << std::endl;
+	struct Edge { std::uint32_t to; std::uint32_t weight; };
+	auto edges{ std::vector<Edge>(n * 8) };
+	for (auto& e : edges)
+	{
+		e = { std::uint32_t(generator() % n),
+			std::uint32_t(1 + generator() % 1000) };
+	}
+	constexpr auto infinity{ std::numeric_limits<std::uint64_t>::max() };
+	using Entry = std::pair<std::uint64_t, std::uint32_t>;
+
+	auto dary_distance{ std::vector<std::uint64_t>(n, infinity) };
+	auto dary_ms{ measure([&]() {
+		auto heap{ DaryHeap<Entry>{} };
+		auto handles{ std::vector<std::uint32_t>(n) };
+		auto queued{ std::vector<bool>(n) };
+		dary_distance[0] = 0;
+		handles[0] = heap.push({ 0, 0 });
+		queued[0] = true;
+		while (!heap.empty())
+		{
+			auto [d, v]{ heap.pop() };
+			queued[v] = false;
+			for (auto i{ v * 8 }; i < v * 8 + 8; i++)
+			{
+				auto [to, w]{ edges[i] };
+				if (d + w >= dary_distance[to]) { continue; }
+				dary_distance[to] = d + w;
+				if (queued[to])
+				{
+					heap.decrease_key(handles[to], { d + w, to });
+				}
+				else
+				{
+					handles[to] = heap.push({ d + w, to });
+					queued[to] = true;
+				}
+			}
+		} }) };
+
+	auto std_distance{ std::vector<std::uint64_t>(n, infinity) };
+	auto std_ms{ measure([&]() {
+		auto heap{ std::priority_queue<Entry, std::vector<Entry>,
+			std::greater<Entry>>{} };
+		std_distance[0] = 0;
+		heap.push({ 0, 0 });
+		while (!heap.empty())
+		{
+			auto [d, v]{ heap.top() };
+			heap.pop();
+			if (d > std_distance[v]) { continue; }
+			for (auto i{ v * 8 }; i < v * 8 + 8; i++)
+			{
+				auto [to, w]{ edges[i] };
+				if (d + w >= std_distance[to]) { continue; }
+				std_distance[to] = d + w;
+				heap.push({ d + w, to });
+			}
+		} }) };
+
+	std::cout << "DaryHeap with decrease_key: " << dary_ms
+		<< " std::priority_queue with duplicates: " << std_ms
+		<< (dary_distance == std_distance ? "" : " DISTANCES DIFFER")
+		<< std::endl;
+
+	// Every thread pushes its share and pops about as much, the items are
+	// random deadlines
+	std::cout << std::endl << "Benchmark, " << n
+		<< " pushes and pops in total, million ops/s" << std::endl;
+	auto keys{ std::vector<std::uint64_t>(n) };
+	for (auto& k : keys) { k = generator(); }
+
+	auto run{ [&](unsigned threads, auto push, auto pop) {
+		auto popped{ std::atomic<long>{ 0 } };
+		auto ms{ measure([&]() {
+			auto t{ std::vector<std::thread>{} };
+			for (unsigned id{ 0 }; id < threads; id++)
+			{
+				t.push_back(std::thread{ [&, id]() {
+					auto local{ 0l };
+					for (auto i{ long(id) }; i < n; i += threads)
+					{
+						push(keys[i]);
+						// Two pushes, one pop: the queue grows
+						if (i % 2 && pop()) { local++; }
+					}
+					while (pop()) { local++; }
+					popped += local;
+				} });
+			}
+			for (auto& _t : t) { _t.join(); } }) };
+		return std::pair{ 2 * n / ms / 1000, popped.load() };
+	} };
+
+	for (auto threads : { 1u, 2u, 4u, 8u })
+	{
+		auto m{ std::mutex{} };
+		auto locked{ std::priority_queue<std::uint64_t,
+			std::vector<std::uint64_t>, std::greater<>>{} };
+		auto [mutex_rate, mutex_popped]{ run(threads,
+			[&](std::uint64_t k) {
+				auto lock{ std::lock_guard(m) };
+				locked.push(k); },
+			[&]() {
+				auto lock{ std::lock_guard(m) };
+				if (locked.empty()) { return false; }
+				locked.pop();
+				return true; }) };
+
+		auto multi{ MultiQueue<std::uint64_t>(threads) };
+		auto [multi_rate, multi_popped]{ run(threads,
+			[&](std::uint64_t k) { multi.push(k); },
+			[&]() { return multi.pop().has_value(); }) };
+
+		std::cout << threads << " threads: mutex + std::priority_queue: "
+			<< mutex_rate << " MultiQueue: " << multi_rate
+			<< (mutex_popped == n && multi_popped == n
+				? "" : " ITEMS LOST") << std::endl;
+	}
+	}
+
+	return 0;
+}
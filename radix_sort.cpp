@@ -0,0 +1,367 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <span>
+#include <bit>
+#include <thread>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+
+// Comparison sorts like std::ranges::sort need O(n log n) comparisons. For
+// integer and floating point keys there is a faster way: the radix sort
+// distributes the items by their digits (bytes here), one pass per byte,
+// O(n) per pass. The passes are stable, so the least significant digit
+// (LSD) first order gives a fully sorted result.
+
+/** \brief   Converts the key to the unsigned integer with the same order
+ *  \details Signed integers get the sign bit flipped. Negative floats are
+ *           inverted completely, positive ones get the sign bit set, so
+ *           the bits compare like the numbers. Descending order is the
+ *           inverted ascending key. */
+template<typename T>
+auto radix_key(T v, bool descending)
+{
+	using U = std::make_unsigned_t<std::conditional_t<std::is_floating_point_v<T>,
+		std::conditional_t<sizeof(T) == 4, std::int32_t, std::int64_t>, T>>;
+	constexpr auto sign{ U(1) << (sizeof(U) * 8 - 1) };
+
+	auto key{ U{} };
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		key = std::bit_cast<U>(v);
+		key = (key & sign) ? ~key : (key | sign);
+	}
+	else if constexpr (std::is_signed_v<T>)
+	{
+		key = U(v) ^ sign;
+	}
+	else
+	{
+		key = v;
+	}
+	return descending ? U(~key) : key;
+}
+
+/** \brief   One LSD pass set over the key array, keeping values in sync
+ *  \details Bytes [0, bytes) of the keys are sorted. Passes where all of
+ *           the keys have the same byte are skipped. The result is left
+ *           in keys/values (buffers are swapped as needed). */
+template<typename U, typename V>
+void lsd_passes(std::vector<U>& keys, std::vector<V>& values,
+		std::vector<U>& keys_tmp, std::vector<V>& values_tmp,
+		std::size_t bytes)
+{
+	auto n{ keys.size() };
+	for (std::size_t b{ 0 }; b < bytes; b++)
+	{
+		auto shift{ b * 8 };
+		auto count{ std::array<std::size_t, 256>{} };
+		for (auto k : keys) { count[(k >> shift) & 0xff]++; }
+		if (std::ranges::find(count, n) != count.end()) { continue; }
+
+		auto offset{ std::size_t{ 0 } };
+		for (auto& c : count) { auto t{ c }; c = offset; offset += t; }
+
+		for (std::size_t i{ 0 }; i < n; i++)
+		{
+			auto pos{ count[(keys[i] >> shift) & 0xff]++ };
+			keys_tmp[pos] = keys[i];
+			values_tmp[pos] = std::move(values[i]);
+		}
+		keys.swap(keys_tmp);
+		values.swap(values_tmp);
+	}
+}
+
+/** \brief   LSD radix sort of integral or floating point values
+ *  \details The values are turned into unsigned keys that sort the same
+ *           way, so two buffers of n keys are allocated: the keys and the
+ *           scratch one the passes alternate with. The sorted keys are
+ *           turned back into the values in data. NaNs are placed at the
+ *           ends. */
+template<typename T>
+	requires std::is_arithmetic_v<T>
+void radix_sort(std::span<T> data, bool descending = false)
+{
+	using U = decltype(radix_key(T{}, false));
+	auto n{ data.size() };
+	auto keys{ std::vector<U>(n) };
+	auto tmp{ std::vector<U>(n) };
+	for (std::size_t i{ 0 }; i < n; i++)
+	{
+		keys[i] = radix_key(data[i], descending);
+	}
+
+	for (std::size_t b{ 0 }; b < sizeof(U); b++)
+	{
+		auto shift{ b * 8 };
+		auto count{ std::array<std::size_t, 256>{} };
+		for (auto k : keys) { count[(k >> shift) & 0xff]++; }
+		if (std::ranges::find(count, n) != count.end()) { continue; }
+
+		auto offset{ std::size_t{ 0 } };
+		for (auto& c : count) { auto t{ c }; c = offset; offset += t; }
+		for (auto k : keys) { tmp[count[(k >> shift) & 0xff]++] = k; }
+		keys.swap(tmp);
+	}
+
+	// The key transformation is reversible, so the values are restored
+	// from the sorted keys
+	for (std::size_t i{ 0 }; i < n; i++)
+	{
+		auto k{ descending ? U(~keys[i]) : keys[i] };
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			constexpr auto sign{ U(1) << (sizeof(U) * 8 - 1) };
+			k = (k & sign) ? (k & ~sign) : ~k;
+			data[i] = std::bit_cast<T>(k);
+		}
+		else if constexpr (std::is_signed_v<T>)
+		{
+			constexpr auto sign{ U(1) << (sizeof(U) * 8 - 1) };
+			data[i] = T(k ^ sign);
+		}
+		else
+		{
+			data[i] = T(k);
+		}
+	}
+}
+
+/** \brief   Sorts the records by the extracted key
+ *  \details Key-index sort: the keys are extracted once and sorted
+ *           together with record indexes, then the records are moved
+ *           into the final order. The sort is stable, records are moved
+ *           exactly twice whatever their size is.
+ *  \param   key Function returning an arithmetic key of the record */
+template<typename T, typename Key>
+void radix_sort_by_key(std::span<T> data, Key key, bool descending = false)
+{
+	using U = decltype(radix_key(key(data[0]), false));
+	auto n{ data.size() };
+	auto keys{ std::vector<U>(n) };
+	auto keys_tmp{ std::vector<U>(n) };
+	auto index{ std::vector<std::uint32_t>(n) };
+	auto index_tmp{ std::vector<std::uint32_t>(n) };
+	for (std::size_t i{ 0 }; i < n; i++)
+	{
+		keys[i] = radix_key(key(data[i]), descending);
+		index[i] = std::uint32_t(i);
+	}
+
+	lsd_passes(keys, index, keys_tmp, index_tmp, sizeof(U));
+
+	auto sorted{ std::vector<T>() };
+	sorted.reserve(n);
+	for (auto i : index) { sorted.push_back(std::move(data[i])); }
+	std::ranges::move(sorted, data.begin());
+}
+
+/** \brief   Parallel MSD radix sort
+ *  \details The first pass distributes the items into 256 buckets by the
+ *           most significant byte: each thread counts and scatters its
+ *           own part of the data, so no locks are needed. Then the
+ *           buckets are independent and are LSD sorted by the threads on
+ *           the rest of the bytes. */
+template<typename T>
+	requires std::is_arithmetic_v<T>
+void parallel_radix_sort(std::span<T> data, bool descending = false,
+		unsigned threads = std::thread::hardware_concurrency())
+{
+	using U = decltype(radix_key(T{}, false));
+	constexpr auto top_shift{ (sizeof(U) - 1) * 8 };
+	threads = std::max(1u, threads);
+	auto n{ data.size() };
+	auto part{ (n + threads - 1) / threads };
+
+	auto count{ std::vector<std::array<std::size_t, 256>>(threads) };
+	auto run{
+		[&](auto&& func) -> void
+		{
+			auto t{ std::vector<std::thread>{} };
+			for (unsigned i{ 0 }; i < threads; i++)
+			{
+				t.push_back(std::thread{ func, i });
+			}
+			for (auto& _t : t) { _t.join(); }
+		}
+	};
+
+	run([&](unsigned id) -> void
+	{
+		auto last{ std::min(n, (id + 1) * part) };
+		for (auto i{ std::min(n, id * part) }; i < last; i++)
+		{
+			count[id][radix_key(data[i], descending) >> top_shift]++;
+		}
+	});
+
+	// Thread id writes bucket b starting after the same bucket of the
+	// previous threads
+	auto bucket_begin{ std::array<std::size_t, 257>{} };
+	auto offset{ std::size_t{ 0 } };
+	for (std::size_t b{ 0 }; b < 256; b++)
+	{
+		bucket_begin[b] = offset;
+		for (unsigned id{ 0 }; id < threads; id++)
+		{
+			auto t{ count[id][b] };
+			count[id][b] = offset;
+			offset += t;
+		}
+	}
+	bucket_begin[256] = n;
+
+	auto buffer{ std::vector<T>(n) };
+	run([&](unsigned id) -> void
+	{
+		auto last{ std::min(n, (id + 1) * part) };
+		for (auto i{ std::min(n, id * part) }; i < last; i++)
+		{
+			auto b{ radix_key(data[i], descending) >> top_shift };
+			buffer[count[id][b]++] = data[i];
+		}
+	});
+
+	// Buckets are handed out round-robin, with 256 buckets the load is
+	// balanced well enough for random keys
+	run([&](unsigned id) -> void
+	{
+		for (std::size_t b{ id }; b < 256; b += threads)
+		{
+			auto first{ bucket_begin[b] };
+			auto size{ bucket_begin[b + 1] - first };
+			auto bucket{ std::span<T>(buffer.data() + first, size) };
+			radix_sort(bucket, descending);
+			std::ranges::copy(bucket, data.begin() + first);
+		}
+	});
+}
+
+struct Record
+{
+	std::int32_t key;
+	double payload[3];
+
+	bool operator==(const Record&) const = default;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Radix sort demo" << std::endl;
+
+	{
+	std::cout << "sorting: " << std::endl;
+	auto x{ std::vector{ 4, 8, 45, 2, 4, 6, 9, -3 } };
+	for (auto& i : x) { std::cout << i << " "; } std::cout << std::endl;
+	radix_sort(std::span(x));
+	for (auto& i : x) { std::cout << i << " "; } std::cout << std::endl;
+	}
+
+	{
+	std::cout << "sorting with descending order: " << std::endl;
+	auto x{ std::vector{ 4, 8, 45, 2, 4, 6, 9, -3 } };
+	radix_sort(std::span(x), true);
+	for (auto& i : x) { std::cout << i << " "; } std::cout << std::endl;
+	}
+
+	{
+	std::cout << "sorting floats: " << std::endl;
+	auto x{ std::vector{ 3.14f, -0.5f, 2.73f, -9.81f, 0.0f, 1e-3f } };
+	radix_sort(std::span(x));
+	for (auto& i : x) { std::cout << i << " "; } std::cout << std::endl;
+	}
+
+	{
+	std::cout << "sorting records by key: " << std::endl;
+	auto x{ std::vector<Record>{ { 3, { 0.3 } }, { -1, { 0.1 } },
+		{ 3, { 0.33 } }, { 2, { 0.2 } } } };
+	radix_sort_by_key(std::span(x), [](auto& r) { return r.key; });
+	for (auto& r : x)
+	{
+		std::cout << r.key << ":" << r.payload[0] << " ";
+	}
+	std::cout << std::endl;
+	}
+
+	{
+	// Element count may be passed as the first argument
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	std::cout << std::endl << "Benchmark, " << n << " items, ms"
+		<< std::endl;
+
+	auto rng{ std::mt19937{ 42 } };
+	auto source{ std::vector<int>(n) };
+	for (auto& i : source) { i = int(rng()); }
+	auto reference{ source };
+	std::ranges::sort(reference);
+
+	// Sorts a copy of the source, then compares it with the expected
+	// result
+	auto bench{
+		[](const char* name, const auto& source, const auto& expected,
+			auto&& sort) -> void
+		{
+			auto data{ source };
+			auto ms{ measure([&]() { sort(data); }) };
+			std::cout << name << ": " << ms
+				<< (data == expected ? "" : " (WRONG ORDER)")
+				<< std::endl;
+		}
+	};
+
+	bench("std::ranges::sort   ", source, reference,
+		[](auto& x) { std::ranges::sort(x); });
+	bench("std::stable_sort    ", source, reference,
+		[](auto& x) { std::stable_sort(x.begin(), x.end()); });
+	bench("radix_sort          ", source, reference,
+		[](auto& x) { radix_sort(std::span(x)); });
+	bench("parallel_radix_sort ", source, reference,
+		[](auto& x) { parallel_radix_sort(std::span(x)); });
+
+	std::ranges::reverse(reference);
+	bench("std::ranges::sort descending ", source, reference,
+		[](auto& x) { std::ranges::sort(x, std::greater<>{}); });
+	bench("radix_sort descending        ", source, reference,
+		[](auto& x) { radix_sort(std::span(x), true); });
+
+	auto f{ std::vector<float>(n) };
+	for (auto& i : f) { i = float(int(rng())) / 1000.0f; }
+	auto f_reference{ f };
+	std::ranges::sort(f_reference);
+	bench("std::ranges::sort floats ", f, f_reference,
+		[](auto& x) { std::ranges::sort(x); });
+	bench("radix_sort floats        ", f, f_reference,
+		[](auto& x) { radix_sort(std::span(x)); });
+
+	auto records{ std::vector<Record>(n) };
+	for (std::size_t i{ 0 }; i < n; i++)
+	{
+		// payload keeps the initial position to check the stability
+		records[i] = { int(rng() % 1000), { double(i) } };
+	}
+	auto by_key{ [](const Record& r) { return r.key; } };
+	auto r_reference{ records };
+	std::ranges::stable_sort(r_reference, {}, by_key);
+	bench("std::stable_sort records ", records, r_reference,
+		[&](auto& x) { std::ranges::stable_sort(x, {}, by_key); });
+	bench("radix_sort_by_key records", records, r_reference,
+		[&](auto& x) { radix_sort_by_key(std::span(x), by_key); });
+	}
+
+	return 0;
+}
@@ -0,0 +1,302 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// std::shared_mutex lets readers in together, but every lock_shared is a
+// write to the same counter, so the cache line with the counter moves between
+// the cores on every read. With many readers that is slower than the work
+// under the lock. Here the readers write only to their own cache lines.
+
+namespace detail
+{
+	// Threads get the reader slots round-robin, once per thread. The slot
+	// belongs to the thread rather than to the current core: the thread may
+	// move to another core between lock_shared and unlock_shared.
+	inline std::size_t reader_slot()
+	{
+		static std::atomic<std::size_t> next{ 0 };
+		thread_local auto slot{ next.fetch_add(1,
+			std::memory_order_relaxed) };
+		return slot;
+	}
+}
+
+/** \brief   Reader-writer lock with a reader counter per cache line
+ *  \details A reader increments its own counter and checks that no writer
+ *           is there. A writer raises the flag and waits until all of the
+ *           counters are zero. Reads scale with the number of threads,
+ *           writes cost a pass over all of the counters. Works with
+ *           std::shared_lock and std::unique_lock.
+ *  \tparam  WriterPreference If true, new readers wait while a writer
+ *           waits. If false, a waiting writer steps back while there are
+ *           readers, so writers may starve under constant reading. */
+template<bool WriterPreference = true, std::size_t Slots = 64>
+class DistributedRwLock
+{
+	public:
+		void lock_shared()
+		{
+			auto& readers{ counters[detail::reader_slot() % Slots].readers };
+			while (true)
+			{
+				// Pairs with the writer: the flag is raised before
+				// the counters are checked, both are seq_cst
+				readers.fetch_add(1);
+				if (!writer.load()) { return; }
+				readers.fetch_sub(1);
+				while (writer.load(std::memory_order_relaxed))
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		bool try_lock_shared()
+		{
+			auto& readers{ counters[detail::reader_slot() % Slots].readers };
+			readers.fetch_add(1);
+			if (!writer.load()) { return true; }
+			readers.fetch_sub(1);
+			return false;
+		}
+
+		void unlock_shared()
+		{
+			counters[detail::reader_slot() % Slots].readers.fetch_sub(1,
+				std::memory_order_release);
+		}
+
+		void lock()
+		{
+			while (true)
+			{
+				while (writer.exchange(true))
+				{
+					std::this_thread::yield();
+				}
+				if (wait_readers()) { return; }
+				// Reader preference: let the readers go on
+				writer.store(false);
+				std::this_thread::yield();
+			}
+		}
+
+		bool try_lock()
+		{
+			if (writer.exchange(true)) { return false; }
+			for (auto& c : counters)
+			{
+				if (c.readers.load() != 0)
+				{
+					writer.store(false);
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void unlock() { writer.store(false, std::memory_order_release); }
+
+	private:
+		// True when there are no readers. With writer preference waits
+		// for them, otherwise gives up at the first active reader.
+		bool wait_readers()
+		{
+			for (auto& c : counters)
+			{
+				while (c.readers.load() != 0)
+				{
+					if (!WriterPreference) { return false; }
+					std::this_thread::yield();
+				}
+			}
+			return true;
+		}
+
+		struct alignas(64) Counter
+		{
+			std::atomic<int> readers{ 0 };
+		};
+
+		std::array<Counter, Slots> counters;
+		alignas(64) std::atomic<bool> writer{ false };
+};
+
+/** \brief   Small value that is read without locks (sequence lock)
+ *  \details The writer makes the sequence number odd, writes the value and
+ *           makes it even again. The reader copies the value and retries if
+ *           the number was odd or has changed. Readers don't write to the
+ *           shared memory at all. The value is kept in atomic words, so the
+ *           copy that races with the writer is not a data race. */
+template<typename T>
+class SeqLock
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	static constexpr std::size_t Words{
+		(sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t) };
+
+	public:
+		SeqLock(const T& value = T{}) { store(value); }
+
+		T load() const
+		{
+			auto buffer{ std::array<std::uint64_t, Words>{} };
+			while (true)
+			{
+				auto before{ sequence.load(std::memory_order_acquire) };
+				if (before & 1)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				for (std::size_t i{ 0 }; i < Words; i++)
+				{
+					buffer[i] = words[i].load(std::memory_order_relaxed);
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (sequence.load(std::memory_order_relaxed) == before)
+				{
+					break;
+				}
+			}
+			auto value{ T{} };
+			std::memcpy(&value, buffer.data(), sizeof(T));
+			return value;
+		}
+
+		/** \brief Writers are serialized by the mutex */
+		void store(const T& value)
+		{
+			auto buffer{ std::array<std::uint64_t, Words>{} };
+			std::memcpy(buffer.data(), &value, sizeof(T));
+
+			auto lock{ std::lock_guard(writers) };
+			auto s{ sequence.load(std::memory_order_relaxed) };
+			sequence.store(s + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (std::size_t i{ 0 }; i < Words; i++)
+			{
+				words[i].store(buffer[i], std::memory_order_relaxed);
+			}
+			sequence.store(s + 2, std::memory_order_release);
+		}
+
+	private:
+		alignas(64) std::atomic<unsigned> sequence{ 0 };
+		std::array<std::atomic<std::uint64_t>, Words> words;
+		std::mutex writers;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Scalable reader-writer lock demo" << std::endl;
+
+	{
+	std::cout << "reading and writing with standard lock guards: ";
+	auto m{ DistributedRwLock<>{} };
+	auto v{ 3.14 };
+	auto t{ std::thread{ [&]() {
+		auto lock{ std::unique_lock(m) };
+		v = 2.73;
+	} } };
+	{
+		auto lock{ std::shared_lock(m) };
+		std::cout << (v == 3.14 || v == 2.73 ? "consistent " : "torn ");
+	}
+	t.join();
+	std::cout << v << std::endl;
+
+	std::cout << "sequence lock: ";
+	auto point{ SeqLock<std::array<double, 3>>{ { 1.0, 2.0, 3.0 } } };
+	point.store({ 4.0, 5.0, 6.0 });
+	for (auto i : point.load()) { std::cout << i << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	std::cout << std::endl << "Benchmark, " << n
+		<< " reads in total, one writer every 100 us, reads/s" << std::endl;
+
+	auto run{
+		[&](int readers, auto read, auto write) -> double
+		{
+			auto done{ std::atomic<bool>{ false } };
+			auto writer{ std::thread{ [&]() {
+				for (auto i{ 0.0 }; !done.load(); i++)
+				{
+					write(i);
+					std::this_thread::sleep_for(
+						std::chrono::microseconds(100));
+				}
+			} } };
+			auto sink{ std::atomic<double>{ 0 } };
+			auto per_thread{ n / readers };
+			auto ms{ measure([&]() {
+				auto t{ std::vector<std::thread>{} };
+				for (int r{ 0 }; r < readers; r++)
+				{
+					t.push_back(std::thread{ [&]() {
+						auto local{ 0.0 };
+						for (long i{ 0 }; i < per_thread; i++)
+						{
+							local += read();
+						}
+						sink = sink + local;
+					} });
+				}
+				for (auto& _t : t) { _t.join(); } }) };
+			done = true;
+			writer.join();
+			return per_thread * readers / ms * 1000;
+		}
+	};
+
+	auto m{ std::mutex{} };
+	auto sm{ std::shared_mutex{} };
+	auto dm{ DistributedRwLock<>{} };
+	auto v{ 3.14 };
+	auto seq{ SeqLock<double>{ 3.14 } };
+
+	for (auto readers : { 1, 2, 4, 8, 16, 32, 64 })
+	{
+		auto mutex_rate{ run(readers,
+			[&]() { auto l{ std::lock_guard(m) }; return v; },
+			[&](double x) { auto l{ std::lock_guard(m) }; v = x; }) };
+		auto shared_rate{ run(readers,
+			[&]() { auto l{ std::shared_lock(sm) }; return v; },
+			[&](double x) { auto l{ std::unique_lock(sm) }; v = x; }) };
+		auto distributed_rate{ run(readers,
+			[&]() { auto l{ std::shared_lock(dm) }; return v; },
+			[&](double x) { auto l{ std::unique_lock(dm) }; v = x; }) };
+		auto seq_rate{ run(readers,
+			[&]() { return seq.load(); },
+			[&](double x) { seq.store(x); }) };
+
+		std::cout << readers << " readers:"
+			<< " std::mutex: " << mutex_rate
+			<< " std::shared_mutex: " << shared_rate
+			<< " DistributedRwLock: " << distributed_rate
+			<< " SeqLock: " << seq_rate << std::endl;
+	}
+	}
+
+	return 0;
+}
@@ -0,0 +1,472 @@
+#include <iostream>
+#include <vector>
+#include <set>
+#include <span>
+#include <bit>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <immintrin.h>
+
+// std::ranges::find, count and min_element check one item per iteration.
+// AVX2 registers hold 8 ints or floats, or 32 bytes, and one instruction
+// compares all of them at once. The AVX2 versions below are compiled for
+// that instruction set with the target attribute, while the rest of the
+// program stays generic: the CPU is checked once at runtime and the
+// scalar version is used if AVX2 is not there.
+namespace simd
+{
+	/** \brief Checks the CPU once, the result is cached */
+	inline bool has_avx2()
+	{
+		static const bool avx2{ __builtin_cpu_supports("avx2") != 0 };
+		return avx2;
+	}
+
+	// Scalar fallbacks
+
+	template<typename T>
+	std::size_t find_scalar(std::span<const T> s, T v)
+	{
+		for (std::size_t i{ 0 }; i < s.size(); i++)
+		{
+			if (s[i] == v) { return i; }
+		}
+		return s.size();
+	}
+
+	template<typename T>
+	std::size_t count_scalar(std::span<const T> s, T v)
+	{
+		auto n{ std::size_t{ 0 } };
+		for (auto i : s) { n += (i == v); }
+		return n;
+	}
+
+	template<typename T>
+	std::size_t find_first_of_scalar(std::span<const T> s,
+			std::span<const T> set)
+	{
+		for (std::size_t i{ 0 }; i < s.size(); i++)
+		{
+			if (std::ranges::find(set, s[i]) != set.end()) { return i; }
+		}
+		return s.size();
+	}
+
+	// AVX2 kernels. Every kernel compares a full register, turns the
+	// comparison result into a bit mask and finishes the tail by the
+	// scalar code.
+
+	__attribute__((target("avx2")))
+	inline unsigned eq_mask(const int* p, __m256i v)
+	{
+		auto x{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) };
+		return unsigned(_mm256_movemask_ps(
+			_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, v))));
+	}
+
+	__attribute__((target("avx2")))
+	inline unsigned eq_mask(const float* p, __m256 v)
+	{
+		return unsigned(_mm256_movemask_ps(
+			_mm256_cmp_ps(_mm256_loadu_ps(p), v, _CMP_EQ_OQ)));
+	}
+
+	__attribute__((target("avx2")))
+	inline unsigned eq_mask(const std::uint8_t* p, __m256i v)
+	{
+		auto x{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) };
+		return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, v)));
+	}
+
+	__attribute__((target("avx2")))
+	inline auto splat(int v) { return _mm256_set1_epi32(v); }
+	__attribute__((target("avx2")))
+	inline auto splat(float v) { return _mm256_set1_ps(v); }
+	__attribute__((target("avx2")))
+	inline auto splat(std::uint8_t v) { return _mm256_set1_epi8(char(v)); }
+
+	template<typename T>
+	constexpr std::size_t lanes{ 32 / sizeof(T) };
+
+	template<typename T>
+	__attribute__((target("avx2")))
+	std::size_t find_avx2(std::span<const T> s, T v)
+	{
+		auto needle{ splat(v) };
+		auto i{ std::size_t{ 0 } };
+		for (; i + lanes<T> <= s.size(); i += lanes<T>)
+		{
+			auto mask{ eq_mask(s.data() + i, needle) };
+			if (mask) { return i + std::countr_zero(mask); }
+		}
+		auto tail{ find_scalar(s.subspan(i), v) };
+		return i + tail;
+	}
+
+	template<typename T>
+	__attribute__((target("avx2")))
+	std::size_t count_avx2(std::span<const T> s, T v)
+	{
+		auto needle{ splat(v) };
+		auto n{ std::size_t{ 0 } };
+		auto i{ std::size_t{ 0 } };
+		for (; i + lanes<T> <= s.size(); i += lanes<T>)
+		{
+			n += std::popcount(eq_mask(s.data() + i, needle));
+		}
+		return n + count_scalar(s.subspan(i), v);
+	}
+
+	template<typename T>
+	__attribute__((target("avx2")))
+	std::size_t find_first_of_avx2(std::span<const T> s,
+			std::span<const T> set)
+	{
+		auto i{ std::size_t{ 0 } };
+		for (; i + lanes<T> <= s.size(); i += lanes<T>)
+		{
+			auto mask{ 0u };
+			for (auto v : set) { mask |= eq_mask(s.data() + i, splat(v)); }
+			if (mask) { return i + std::countr_zero(mask); }
+		}
+		return i + find_first_of_scalar(s.subspan(i), set);
+	}
+
+	__attribute__((target("avx2")))
+	inline int min_avx2(std::span<const int> s)
+	{
+		auto m{ _mm256_set1_epi32(s[0]) };
+		auto i{ std::size_t{ 0 } };
+		for (; i + 8 <= s.size(); i += 8)
+		{
+			m = _mm256_min_epi32(m, _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(s.data() + i)));
+		}
+		alignas(32) int r[8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(r), m);
+		auto result{ *std::min_element(r, r + 8) };
+		for (; i < s.size(); i++) { result = std::min(result, s[i]); }
+		return result;
+	}
+
+	__attribute__((target("avx2")))
+	inline float min_avx2(std::span<const float> s)
+	{
+		auto m{ _mm256_set1_ps(s[0]) };
+		auto i{ std::size_t{ 0 } };
+		for (; i + 8 <= s.size(); i += 8)
+		{
+			m = _mm256_min_ps(m, _mm256_loadu_ps(s.data() + i));
+		}
+		alignas(32) float r[8];
+		_mm256_store_ps(r, m);
+		auto result{ *std::min_element(r, r + 8) };
+		for (; i < s.size(); i++) { result = std::min(result, s[i]); }
+		return result;
+	}
+
+	__attribute__((target("avx2")))
+	inline int max_avx2(std::span<const int> s)
+	{
+		auto m{ _mm256_set1_epi32(s[0]) };
+		auto i{ std::size_t{ 0 } };
+		for (; i + 8 <= s.size(); i += 8)
+		{
+			m = _mm256_max_epi32(m, _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(s.data() + i)));
+		}
+		alignas(32) int r[8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(r), m);
+		auto result{ *std::max_element(r, r + 8) };
+		for (; i < s.size(); i++) { result = std::max(result, s[i]); }
+		return result;
+	}
+
+	__attribute__((target("avx2")))
+	inline float max_avx2(std::span<const float> s)
+	{
+		auto m{ _mm256_set1_ps(s[0]) };
+		auto i{ std::size_t{ 0 } };
+		for (; i + 8 <= s.size(); i += 8)
+		{
+			m = _mm256_max_ps(m, _mm256_loadu_ps(s.data() + i));
+		}
+		alignas(32) float r[8];
+		_mm256_store_ps(r, m);
+		auto result{ *std::max_element(r, r + 8) };
+		for (; i < s.size(); i++) { result = std::max(result, s[i]); }
+		return result;
+	}
+
+	// Public interface: int, float and byte spans. Search functions
+	// return the index of the found item or s.size(), like the end
+	// iterator.
+
+	template<typename T>
+	concept Searchable = std::same_as<T, int> || std::same_as<T, float>
+		|| std::same_as<T, std::uint8_t>;
+
+	template<Searchable T>
+	std::size_t find(std::span<const T> s, T v)
+	{
+		return has_avx2() ? find_avx2(s, v) : find_scalar(s, v);
+	}
+
+	template<Searchable T>
+	std::size_t count(std::span<const T> s, T v)
+	{
+		return has_avx2() ? count_avx2(s, v) : count_scalar(s, v);
+	}
+
+	template<Searchable T>
+	bool contains(std::span<const T> s, T v)
+	{
+		return find(s, v) != s.size();
+	}
+
+	/** \brief Index of the first item equal to any item of the set */
+	template<Searchable T>
+	std::size_t find_first_of(std::span<const T> s, std::span<const T> set)
+	{
+		return has_avx2() ? find_first_of_avx2(s, set)
+			: find_first_of_scalar(s, set);
+	}
+
+	/** \brief   Index of the first minimal item, s.size() for empty span
+	 *  \details The minimal value is found by a vertical min, then its
+	 *           position by the vectorized find. Floats should not be
+	 *           NaNs. */
+	template<typename T>
+		requires std::same_as<T, int> || std::same_as<T, float>
+	std::size_t min_element(std::span<const T> s)
+	{
+		if (s.empty()) { return 0; }
+		if (!has_avx2())
+		{
+			return std::ranges::min_element(s) - s.begin();
+		}
+		return find_avx2(s, min_avx2(s));
+	}
+
+	/** \brief Index of the first maximal item, s.size() for empty span */
+	template<typename T>
+		requires std::same_as<T, int> || std::same_as<T, float>
+	std::size_t max_element(std::span<const T> s)
+	{
+		if (s.empty()) { return 0; }
+		if (!has_avx2())
+		{
+			return std::ranges::max_element(s) - s.begin();
+		}
+		return find_avx2(s, max_avx2(s));
+	}
+}
+
+/** \brief   Lower bound of the sorted span without unpredictable branches
+ *  \details The loop always runs log2(n) times and the comparison result
+ *           is turned into a conditional move, so the CPU never mispredicts
+ *           the direction. */
+template<typename T>
+std::size_t branchless_lower_bound(std::span<const T> s, T v)
+{
+	if (s.empty()) { return 0; }
+	auto base{ s.data() };
+	auto n{ s.size() };
+	while (n > 1)
+	{
+		auto half{ n / 2 };
+		base = (base[half] < v) ? base + half : base;
+		n -= half;
+	}
+	return (base - s.data()) + (*base < v);
+}
+
+/** \brief   Sorted set stored in the Eytzinger (breadth-first) layout
+ *  \details The item k has its children at 2k and 2k+1, so the first
+ *           levels of the search tree share a few cache lines and the next
+ *           levels may be prefetched ahead. */
+template<typename T>
+class EytzingerSet
+{
+	public:
+		/** \brief Builds the layout from the sorted unique items */
+		EytzingerSet(std::span<const T> sorted)
+			: items(sorted.size() + 1)
+		{
+			auto i{ std::size_t{ 0 } };
+			build(sorted, i, 1);
+		}
+
+		bool contains(T v) const
+		{
+			auto k{ lower_bound(v) };
+			return k != 0 && items[k] == v;
+		}
+
+		std::size_t size() const { return items.size() - 1; }
+
+	private:
+		// In-order walk of the implicit tree takes the sorted items one
+		// by one
+		void build(std::span<const T> sorted, std::size_t& i, std::size_t k)
+		{
+			if (k >= items.size()) { return; }
+			build(sorted, i, 2 * k);
+			items[k] = sorted[i++];
+			build(sorted, i, 2 * k + 1);
+		}
+
+		// Returns the layout index of the first item not less than v,
+		// or 0 if there is no such item
+		std::size_t lower_bound(T v) const
+		{
+			auto n{ items.size() };
+			auto k{ std::size_t{ 1 } };
+			while (k < n)
+			{
+				// 16 levels ahead is 4 cache lines of ints
+				__builtin_prefetch(items.data() + std::min(k * 16, n - 1));
+				k = 2 * k + (items[k] < v);
+			}
+			// Going up while we went right, then one more level
+			return k >> (std::countr_one(k) + 1);
+		}
+
+		std::vector<T> items;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "SIMD search demo" << std::endl;
+	std::cout << "AVX2 is " << (simd::has_avx2() ? "" : "not ")
+		<< "available" << std::endl;
+
+	auto x{ std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 3 } };
+	auto s{ std::span<const int>(x) };
+
+	std::cout << "searching item: " << x[simd::find(s, 3)] << " at "
+		<< simd::find(s, 3) << std::endl;
+	std::cout << "counting items: " << simd::count(s, 3) << std::endl;
+	std::cout << "checking the item: " << simd::contains(s, 42)
+		<< std::endl;
+	std::cout << "searching any of items: "
+		<< simd::find_first_of(s, std::span<const int>(
+			std::vector{ 9, 7 })) << std::endl;
+	std::cout << "min and max: " << x[simd::min_element(s)] << " "
+		<< x[simd::max_element(s)] << std::endl;
+
+	auto text{ std::string("modern C++ in examples") };
+	auto bytes{ std::span<const std::uint8_t>(
+		reinterpret_cast<const std::uint8_t*>(text.data()), text.size()) };
+	std::cout << "searching byte: " << simd::find(bytes, std::uint8_t('+'))
+		<< std::endl;
+
+	auto sorted{ std::vector<int>{ 1, 3, 5, 7, 9, 11 } };
+	auto e{ EytzingerSet<int>(sorted) };
+	std::cout << "sorted search: lower bound of 6 is "
+		<< branchless_lower_bound(std::span<const int>(sorted), 6)
+		<< ", 7 is " << (e.contains(7) ? "in set" : "not in set")
+		<< ", 8 is " << (e.contains(8) ? "in set" : "not in set")
+		<< std::endl;
+
+	{
+	// Element count may be passed as the first argument
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	auto repeat{ 20 };
+	std::cout << std::endl << "Benchmark, " << n << " items, "
+		<< repeat << " repeats, ms" << std::endl;
+
+	auto rng{ std::mt19937{ 42 } };
+	auto v{ std::vector<int>(n) };
+	for (auto& i : v) { i = int(rng() % 1'000'000) + 1; }
+	auto f{ std::vector<float>(v.begin(), v.end()) };
+	// The searched items are absent, so the whole range is scanned
+	auto sv{ std::span<const int>(v) };
+	auto sf{ std::span<const float>(f) };
+	auto sink{ 0ul };
+
+	auto row{
+		[&](const char* name, auto&& std_way, auto&& simd_way) -> void
+		{
+			auto a{ measure([&]() {
+				for (int r{ 0 }; r < repeat; r++) { sink += std_way(); }
+				}) };
+			auto b{ measure([&]() {
+				for (int r{ 0 }; r < repeat; r++) { sink += simd_way(); }
+				}) };
+			std::cout << name << " std: " << a << " simd: " << b
+				<< std::endl;
+		}
+	};
+
+	row("find int     ",
+		[&]() { return std::ranges::find(v, 0) - v.begin(); },
+		[&]() { return simd::find(sv, 0); });
+	row("find float   ",
+		[&]() { return std::ranges::find(f, 0.0f) - f.begin(); },
+		[&]() { return simd::find(sf, 0.0f); });
+	row("count int    ",
+		[&]() { return std::ranges::count(v, 42); },
+		[&]() { return simd::count(sv, 42); });
+	auto set{ std::vector{ -1, -2, -3, -4 } };
+	row("find_first_of",
+		[&]() { return std::ranges::find_first_of(v, set) - v.begin(); },
+		[&]() { return simd::find_first_of(sv,
+			std::span<const int>(set)); });
+	row("min_element  ",
+		[&]() { return std::ranges::min_element(v) - v.begin(); },
+		[&]() { return simd::min_element(sv); });
+	row("max float    ",
+		[&]() { return std::ranges::max_element(f) - f.begin(); },
+		[&]() { return simd::max_element(sf); });
+
+	auto keys{ v };
+	std::ranges::sort(keys);
+	keys.erase(std::ranges::unique(keys).begin(), keys.end());
+	auto tree{ std::set<int>(keys.begin(), keys.end()) };
+	auto eytzinger{ EytzingerSet<int>(keys) };
+	auto queries{ std::vector<int>(n) };
+	for (auto& i : queries) { i = int(rng() % 1'000'000); }
+
+	auto lookup{
+		[&](const char* name, auto&& func) -> void
+		{
+			auto found{ 0ul };
+			auto ms{ measure([&]() {
+				for (auto q : queries) { found += func(q); } }) };
+			std::cout << name << ": " << ms << " (found " << found
+				<< ")" << std::endl;
+		}
+	};
+	std::cout << n << " lookups in " << keys.size() << " sorted keys"
+		<< std::endl;
+	lookup("std::set::contains       ",
+		[&](int q) { return tree.contains(q); });
+	lookup("std::ranges::binary_search",
+		[&](int q) { return std::ranges::binary_search(keys, q); });
+	lookup("branchless_lower_bound   ",
+		[&](int q) {
+			auto i{ branchless_lower_bound(
+				std::span<const int>(keys), q) };
+			return i < keys.size() && keys[i] == q; });
+	lookup("EytzingerSet::contains   ",
+		[&](int q) { return eytzinger.contains(q); });
+
+	std::cout << "checksum: " << sink << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,299 @@
+#include <iostream>
+#include <any>
+#include <array>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include "type_name.h"
+
+/** \brief   std::any replacement with the configurable inline buffer
+ *  \details Values up to Capacity bytes that may be moved without
+ *           exceptions are stored inside the object, bigger ones on the
+ *           heap. libstdc++'s std::any keeps only pointer-sized values
+ *           inline. With Copyable = false the object is move-only and
+ *           accepts move-only values like std::unique_ptr.
+ *  \tparam  Capacity Size of the inline buffer in bytes
+ *  \tparam  Copyable Whether SmallAny (and the held values) are copyable */
+template<std::size_t Capacity = 32, bool Copyable = true>
+class SmallAny
+{
+	// Table of operations, one static instance per held type
+	struct Operations
+	{
+		TypeId type;
+		void (*destroy)(SmallAny&);
+		void (*move)(SmallAny& from, SmallAny& to);
+		void (*copy)(const SmallAny& from, SmallAny& to);
+	};
+
+	template<typename T>
+	static constexpr bool inline_v{ sizeof(T) <= Capacity
+		&& alignof(T) <= alignof(std::max_align_t)
+		&& std::is_nothrow_move_constructible_v<T> };
+
+	template<typename T>
+	static T* pointer(SmallAny& a)
+	{
+		if constexpr (inline_v<T>)
+		{
+			return std::launder(reinterpret_cast<T*>(a.storage));
+		}
+		else
+		{
+			return static_cast<T*>(a.heap);
+		}
+	}
+
+	template<typename T>
+	static constexpr Operations operations_for{
+		type_id<std::remove_cvref_t<T>>(),
+		[](SmallAny& a) -> void
+		{
+			if constexpr (inline_v<T>) { std::destroy_at(pointer<T>(a)); }
+			else { delete pointer<T>(a); }
+		},
+		[](SmallAny& from, SmallAny& to) -> void
+		{
+			if constexpr (inline_v<T>)
+			{
+				std::construct_at(reinterpret_cast<T*>(to.storage),
+					std::move(*pointer<T>(from)));
+				std::destroy_at(pointer<T>(from));
+			}
+			else
+			{
+				to.heap = from.heap;
+			}
+		},
+		[](const SmallAny& from, SmallAny& to) -> void
+		{
+			if constexpr (Copyable)
+			{
+				auto& src{ *pointer<T>(const_cast<SmallAny&>(from)) };
+				if constexpr (inline_v<T>)
+				{
+					std::construct_at(
+						reinterpret_cast<T*>(to.storage), src);
+				}
+				else
+				{
+					to.heap = new T(src);
+				}
+			}
+		}
+	};
+
+	public:
+		SmallAny() = default;
+
+		template<typename T>
+			requires (!std::is_same_v<std::remove_cvref_t<T>, SmallAny>)
+		SmallAny(T&& value) { emplace<std::remove_cvref_t<T>>(
+			std::forward<T>(value)); }
+
+		SmallAny(const SmallAny& obj) requires Copyable
+		{
+			if (obj.ops) { obj.ops->copy(obj, *this); ops = obj.ops; }
+		}
+
+		SmallAny(SmallAny&& obj) noexcept
+		{
+			if (obj.ops)
+			{
+				obj.ops->move(obj, *this);
+				ops = std::exchange(obj.ops, nullptr);
+			}
+		}
+
+		SmallAny& operator=(const SmallAny& obj) requires Copyable
+		{
+			if (this != &obj) { *this = SmallAny(obj); }
+			return *this;
+		}
+
+		SmallAny& operator=(SmallAny&& obj) noexcept
+		{
+			if (this != &obj)
+			{
+				reset();
+				if (obj.ops)
+				{
+					obj.ops->move(obj, *this);
+					ops = std::exchange(obj.ops, nullptr);
+				}
+			}
+			return *this;
+		}
+
+		template<typename T>
+			requires (!std::is_same_v<std::remove_cvref_t<T>, SmallAny>)
+		SmallAny& operator=(T&& value)
+		{
+			emplace<std::remove_cvref_t<T>>(std::forward<T>(value));
+			return *this;
+		}
+
+		~SmallAny() { reset(); }
+
+		/** \brief   Constructs a new value and destroys the held one
+		 *  \details The new value is built in a temporary first, so args
+		 *           may refer to the held value, and if the constructor
+		 *           throws the held value is kept. */
+		template<typename T, typename... Args>
+		T& emplace(Args&&... args)
+		{
+			static_assert(!Copyable || std::is_copy_constructible_v<T>,
+				"use SmallAny<N, false> for move-only types");
+			auto value{ SmallAny{} };
+			if constexpr (inline_v<T>)
+			{
+				std::construct_at(reinterpret_cast<T*>(value.storage),
+					std::forward<Args>(args)...);
+			}
+			else
+			{
+				value.heap = new T(std::forward<Args>(args)...);
+			}
+			value.ops = &operations_for<T>;
+			*this = std::move(value);
+			return *pointer<T>(*this);
+		}
+
+		void reset()
+		{
+			if (ops) { ops->destroy(*this); ops = nullptr; }
+		}
+
+		bool has_value() const { return ops != nullptr; }
+
+		/** \brief Type id of the held value, nullptr if empty */
+		TypeId type() const { return ops ? ops->type : nullptr; }
+
+		template<typename T>
+		bool holds() const
+		{
+			return type() == type_id<std::remove_cvref_t<T>>();
+		}
+
+		/** \brief Pointer to the held value or nullptr if it's not T */
+		template<typename T>
+		T* get_if()
+		{
+			return holds<T>() ? pointer<T>(*this) : nullptr;
+		}
+
+		template<typename T>
+		const T* get_if() const
+		{
+			return const_cast<SmallAny*>(this)->template get_if<T>();
+		}
+
+	private:
+		union
+		{
+			alignas(std::max_align_t) std::byte storage[Capacity];
+			void* heap;
+		};
+		const Operations* ops{ nullptr };
+};
+
+/** \brief Extracts the value like std::any_cast, throws on type mismatch */
+template<typename T, std::size_t N, bool C>
+T any_cast(const SmallAny<N, C>& a)
+{
+	auto p{ a.template get_if<std::remove_cvref_t<T>>() };
+	if (!p) { throw std::bad_any_cast(); }
+	return *p;
+}
+
+template<typename T, std::size_t N, bool C>
+T* any_cast(SmallAny<N, C>* a) { return a->template get_if<T>(); }
+
+struct Large
+{
+	double data[16];
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Small any demo" << std::endl;
+
+	{
+	auto x{ SmallAny<>{ 1 } };
+
+	std::cout << "extracting value from any: "
+		<< (x.holds<int>() ? "int" : "?") << " x = "
+		<< any_cast<int>(x) << std::endl;
+
+	std::cout << "assigning value to any: ";
+	x = 3.14;
+	std::cout << (x.holds<double>() ? "double" : "?") << " x = "
+		<< any_cast<double>(x) << std::endl;
+
+	std::cout << "wrong type: ";
+	try { any_cast<int>(x); }
+	catch (const std::bad_any_cast& e) { std::cout << e.what(); }
+	std::cout << std::endl;
+
+	std::cout << "move-only value: ";
+	auto y{ SmallAny<16, false>{ std::make_unique<std::string>("foo") } };
+	auto z{ std::move(y) };
+	std::cout << **any_cast<std::unique_ptr<std::string>>(&z)
+		<< ", y " << (y.has_value() ? "has value" : "is empty")
+		<< std::endl;
+
+	std::cout << "sizes: std::any " << sizeof(std::any)
+		<< ", SmallAny<> " << sizeof(SmallAny<>) << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	std::cout << std::endl << "Benchmark, " << n
+		<< " assignments and casts, ms" << std::endl;
+
+	auto row{
+		[&](const char* name, auto value) -> void
+		{
+			using T = decltype(value);
+			auto sink{ 0l };
+			auto a{ std::any{} };
+			auto std_ms{ measure([&]() {
+				for (long i{ 0 }; i < n; i++)
+				{
+					a = value;
+					sink += std::any_cast<T>(&a) != nullptr;
+				} }) };
+			auto s{ SmallAny<>{} };
+			auto small_ms{ measure([&]() {
+				for (long i{ 0 }; i < n; i++)
+				{
+					s = value;
+					sink += s.get_if<T>() != nullptr;
+				} }) };
+			std::cout << name << " std::any: " << std_ms
+				<< " SmallAny: " << small_ms
+				<< " (" << sink << ")" << std::endl;
+		}
+	};
+
+	row("int (4 bytes)             ", 42);
+	row("std::array (32 bytes)     ", std::array<double, 4>{ 1.0 });
+	row("std::string (32 bytes)    ", std::string("short string"));
+	row("Large (128 bytes, on heap)", Large{ { 1.0 } });
+	}
+
+	return 0;
+}
@@ -0,0 +1,253 @@
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+/** \brief   Vector of tuples stored as a tuple of vectors
+ *  \details Every tuple element lives in its own contiguous column
+ *           (structure of arrays). A loop that reads a few fields of every
+ *           row touches only these columns, and the columns of plain
+ *           numbers are easy to vectorize. */
+template<typename... Ts>
+class SoaTupleVector
+{
+	// Columns must be real arrays: std::vector<bool> has no data() and its
+	// items are proxies that can't be bound to references
+	static_assert((!std::is_same_v<Ts, bool> && ...),
+		"bool columns are not supported, use unsigned char instead");
+
+	public:
+		void reserve(std::size_t n)
+		{
+			std::apply([&](auto&... c) { (c.reserve(n), ...); }, columns);
+		}
+
+		void push_back(Ts... values)
+		{
+			push_back(std::index_sequence_for<Ts...>{},
+				std::move(values)...);
+		}
+
+		void push_back(const std::tuple<Ts...>& row)
+		{
+			std::apply([&](auto&... v) { push_back(v...); }, row);
+		}
+
+		/** \brief Row as the tuple of references to the column items */
+		std::tuple<Ts&...> operator[](std::size_t i)
+		{
+			return std::apply(
+				[&](auto&... c) { return std::tie(c[i]...); }, columns);
+		}
+
+		/** \brief Column with the I-th tuple element of every row */
+		template<std::size_t I>
+		auto& column() { return std::get<I>(columns); }
+
+		template<std::size_t I>
+		const auto& column() const { return std::get<I>(columns); }
+
+		std::size_t size() const { return std::get<0>(columns).size(); }
+
+	private:
+		template<std::size_t... I>
+		void push_back(std::index_sequence<I...>, Ts&&... values)
+		{
+			(std::get<I>(columns).push_back(std::move(values)), ...);
+		}
+
+		std::tuple<std::vector<Ts>...> columns;
+};
+
+namespace detail
+{
+	// Calls f on the rows [first, last), the results go to out if
+	// there's an output
+	template<typename F, typename Out, typename... Ts, std::size_t... I>
+	void apply_range(F& f, const SoaTupleVector<Ts...>& soa, Out* out,
+			std::size_t first, std::size_t last,
+			std::index_sequence<I...>)
+	{
+		// Column pointers are taken once, so the loop body is just
+		// indexed loads
+		auto data{ std::make_tuple(soa.template column<I>().data()...) };
+		for (auto i{ first }; i < last; i++)
+		{
+			if constexpr (std::is_void_v<Out>)
+			{
+				std::invoke(f, std::get<I>(data)[i]...);
+			}
+			else
+			{
+				out[i] = std::invoke(f, std::get<I>(data)[i]...);
+			}
+		}
+	}
+}
+
+/** \brief   Calls f with the elements of every row, like std::apply
+ *  \details The columns are walked in parallel by the index. If f returns
+ *           a value, the results are returned as a vector, so the result
+ *           type must be default constructible.
+ *  \param   threads Number of threads, the rows are split into equal
+ *           parts. f should be safe to call concurrently when threads is
+ *           more than 1. */
+template<typename F, typename... Ts>
+auto batch_apply(F f, const SoaTupleVector<Ts...>& soa, unsigned threads = 1)
+{
+	using R = std::invoke_result_t<F&, const Ts&...>;
+	// std::vector<bool> packs the bits and has no data(), so the results
+	// of predicates are collected as bytes and converted at the end
+	using Out = std::conditional_t<std::is_void_v<R>, void,
+		std::conditional_t<std::is_same_v<R, bool>, unsigned char, R>>;
+	// The results are written by index from several threads, so the vector
+	// is sized up front
+	static_assert(std::is_void_v<R> || std::is_default_constructible_v<R>,
+		"the result of f must be default constructible");
+	auto n{ soa.size() };
+	auto seq{ std::index_sequence_for<Ts...>{} };
+
+	auto results{ std::conditional_t<std::is_void_v<R>,
+		std::tuple<>, std::vector<Out>>{} };
+	Out* out{ nullptr };
+	if constexpr (!std::is_void_v<R>)
+	{
+		results.resize(n);
+		out = results.data();
+	}
+
+	threads = std::max(1u, threads);
+	if (threads == 1)
+	{
+		detail::apply_range(f, soa, out, 0, n, seq);
+	}
+	else
+	{
+		auto part{ (n + threads - 1) / threads };
+		auto t{ std::vector<std::thread>{} };
+		for (unsigned id{ 0 }; id < threads; id++)
+		{
+			auto first{ std::min(n, id * part) };
+			auto last{ std::min(n, first + part) };
+			t.push_back(std::thread{ [&, first, last]() {
+				detail::apply_range(f, soa, out, first, last, seq);
+			} });
+		}
+		for (auto& _t : t) { _t.join(); }
+	}
+
+	if constexpr (std::is_same_v<R, bool>)
+	{
+		return std::vector<bool>(results.begin(), results.end());
+	}
+	else if constexpr (!std::is_void_v<R>) { return results; }
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Structure of arrays batch apply demo" << std::endl;
+
+	{
+	auto func{
+		[](int i, const std::string& s, double d) -> int
+		{
+			std::cout << "func:"
+				<< "i: " << i << ", "
+				<< "s: " << s << ", "
+				<< "d: " << d << std::endl;
+
+			return 300 + i;
+		}
+	};
+
+	auto args{ SoaTupleVector<int, std::string, double>{} };
+	args.push_back(0, "foo", 3.14);
+	args.push_back(1, "bar", 9.81);
+	args.push_back(std::make_tuple(2, std::string("baz"), 2.73));
+
+	std::cout << "calling function for every row: " << std::endl;
+	auto r{ batch_apply(func, args) };
+	std::cout << "results: ";
+	for (auto i : r) { std::cout << i << " "; }
+	std::cout << std::endl;
+
+	std::cout << "predicate for every row: ";
+	auto matches{ batch_apply([](int i, const std::string&, double d) {
+		return i % 2 == 0 && d > 3; }, args, 2) };
+	for (bool b : matches) { std::cout << b << " "; }
+	std::cout << std::endl;
+
+	std::cout << "accessing the row: " << std::get<1>(args[1])
+		<< std::endl;
+	std::cout << "accessing the column: ";
+	for (auto& s : args.column<1>()) { std::cout << s << " "; }
+	std::cout << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stoul(argv[1]) : 1'000'000ul };
+	auto threads{ std::max(2u, std::thread::hardware_concurrency()) };
+	std::cout << std::endl << "Benchmark, " << n << " rows, ms"
+		<< std::endl;
+
+	// Only a part of the fields are used, like in the most of loops
+	using Row = std::tuple<int, float, double, long, std::string>;
+	auto func{
+		[](int i, float f, double d, long, const std::string&) -> double
+		{
+			return i * f + d;
+		}
+	};
+
+	auto rows{ std::vector<Row>{} };
+	auto soa{ SoaTupleVector<int, float, double, long, std::string>{} };
+	rows.reserve(n);
+	soa.reserve(n);
+	for (std::size_t i{ 0 }; i < n; i++)
+	{
+		auto row{ Row{ int(i), 0.5f, 1.5, long(i), "row" } };
+		rows.push_back(row);
+		soa.push_back(row);
+	}
+
+	auto sum{ [](const std::vector<double>& v) {
+		auto s{ 0.0 };
+		for (auto i : v) { s += i; }
+		return s; } };
+
+	auto aos{ std::vector<double>{} };
+	auto aos_ms{ measure([&]() {
+		aos.reserve(n);
+		for (auto& r : rows) { aos.push_back(std::apply(func, r)); } }) };
+	auto result{ std::vector<double>{} };
+	auto soa_ms{ measure([&]() { result = batch_apply(func, soa); }) };
+	auto same{ sum(aos) == sum(result) };
+	auto par_ms{ measure([&]() {
+		result = batch_apply(func, soa, threads); }) };
+	same = same && sum(aos) == sum(result);
+
+	std::cout << "std::vector<std::tuple> + std::apply: " << aos_ms
+		<< std::endl;
+	std::cout << "batch_apply: " << soa_ms << std::endl;
+	std::cout << "batch_apply, " << threads << " threads: " << par_ms
+		<< std::endl;
+	std::cout << (same ? "results match" : "RESULTS DIFFER") << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,411 @@
+#include <iostream>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <string>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+
+/** \brief   Wait-free queue for one producer and one consumer thread
+ *  \details Indexes grow forever and are masked by Capacity - 1. Each side
+ *           owns its index and keeps a copy of the other side's index, so
+ *           the shared cache line is read only when the copy says the ring
+ *           is full (producer) or empty (consumer), not on every call. The
+ *           try_ functions finish in a bounded number of steps.
+ *  \tparam  Capacity Number of slots, a power of two */
+template<typename T, std::size_t Capacity>
+class SpscRing
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+		"Capacity should be a power of two");
+
+	static constexpr std::size_t Mask{ Capacity - 1 };
+	static constexpr std::size_t CacheLine{ 64 };
+
+	public:
+		SpscRing() = default;
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+
+		~SpscRing()
+		{
+			auto head{ consumer.index.load(std::memory_order_relaxed) };
+			auto tail{ producer.index.load(std::memory_order_relaxed) };
+			for (; head != tail; head++) { std::destroy_at(slot(head)); }
+		}
+
+		/** \brief Producer: constructs the item, false if the ring is
+		 *         full */
+		template<typename... Args>
+		bool try_emplace(Args&&... args)
+		{
+			auto tail{ producer.index.load(std::memory_order_relaxed) };
+			if (tail - producer.cached == Capacity)
+			{
+				producer.cached =
+					consumer.index.load(std::memory_order_acquire);
+				if (tail - producer.cached == Capacity) { return false; }
+			}
+			std::construct_at(slot(tail), std::forward<Args>(args)...);
+			producer.index.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool try_push(const T& value) { return try_emplace(value); }
+		bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+		/** \brief   Producer: moves items from [first, last) while there's
+		 *           space, returns the number of pushed items
+		 *  \details The consumer sees the whole batch at once, after one
+		 *           store of the index. */
+		template<typename It>
+		std::size_t push_batch(It first, It last)
+		{
+			auto tail{ producer.index.load(std::memory_order_relaxed) };
+			auto wanted{ std::size_t(std::distance(first, last)) };
+			if (Capacity - (tail - producer.cached) < wanted)
+			{
+				producer.cached =
+					consumer.index.load(std::memory_order_acquire);
+			}
+			auto count{ std::min(wanted,
+				Capacity - (tail - producer.cached)) };
+			for (std::size_t i{ 0 }; i < count; i++, ++first)
+			{
+				std::construct_at(slot(tail + i), std::move(*first));
+			}
+			producer.index.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		/** \brief Consumer: the oldest item, nullopt if the ring is
+		 *         empty */
+		std::optional<T> try_pop()
+		{
+			auto head{ consumer.index.load(std::memory_order_relaxed) };
+			if (head == consumer.cached)
+			{
+				consumer.cached =
+					producer.index.load(std::memory_order_acquire);
+				if (head == consumer.cached) { return std::nullopt; }
+			}
+			auto value{ std::optional<T>{ std::move(*slot(head)) } };
+			std::destroy_at(slot(head));
+			consumer.index.store(head + 1, std::memory_order_release);
+			return value;
+		}
+
+		/** \brief Consumer: moves up to max items to out, returns the
+		 *         number of popped items */
+		template<typename Out>
+		std::size_t pop_batch(Out out, std::size_t max)
+		{
+			auto head{ consumer.index.load(std::memory_order_relaxed) };
+			if (consumer.cached - head < max)
+			{
+				consumer.cached =
+					producer.index.load(std::memory_order_acquire);
+			}
+			auto count{ std::min(max, consumer.cached - head) };
+			for (std::size_t i{ 0 }; i < count; i++, ++out)
+			{
+				*out = std::move(*slot(head + i));
+				std::destroy_at(slot(head + i));
+			}
+			consumer.index.store(head + count, std::memory_order_release);
+			return count;
+		}
+
+		/** \brief Number of items, exact only when called by one of the
+		 *         sides while the other one is idle */
+		std::size_t size() const
+		{
+			return producer.index.load(std::memory_order_acquire)
+				- consumer.index.load(std::memory_order_acquire);
+		}
+
+		static constexpr std::size_t capacity() { return Capacity; }
+
+	private:
+		T* slot(std::size_t i)
+		{
+			return std::launder(reinterpret_cast<T*>(
+				storage + (i & Mask) * sizeof(T)));
+		}
+
+		// Index of the side and its copy of the other side's index,
+		// written by one thread only
+		struct alignas(CacheLine) Side
+		{
+			std::atomic<std::size_t> index{ 0 };
+			std::size_t cached{ 0 };
+		};
+
+		Side producer;
+		Side consumer;
+		alignas(CacheLine) alignas(T)
+			std::byte storage[Capacity * sizeof(T)];
+};
+
+namespace stream
+{
+	// Spins a little, then gives the CPU away
+	inline void backoff(unsigned& spins)
+	{
+		if (++spins < 64) { return; }
+		std::this_thread::yield();
+	}
+
+	template<typename T, std::size_t Capacity>
+	struct Channel
+	{
+		SpscRing<T, Capacity> ring;
+		std::atomic<bool> closed{ false };
+	};
+
+	/** \brief Producer end of the stream, like std::promise for many
+	 *         values. The stream is closed when it's destroyed. */
+	template<typename T, std::size_t Capacity>
+	class Sender
+	{
+		public:
+			explicit Sender(std::shared_ptr<Channel<T, Capacity>> c)
+				: channel(std::move(c)) {}
+			Sender(Sender&&) = default;
+
+			Sender& operator=(Sender&& obj)
+			{
+				if (this != &obj)
+				{
+					close();
+					channel = std::move(obj.channel);
+				}
+				return *this;
+			}
+
+			~Sender() { close(); }
+
+			/** \brief Waits for the space if the ring is full */
+			void push(T value)
+			{
+				unsigned spins{ 0 };
+				while (!channel->ring.try_push(std::move(value)))
+				{
+					backoff(spins);
+				}
+			}
+
+			void close()
+			{
+				if (channel)
+				{
+					channel->closed.store(true,
+						std::memory_order_release);
+				}
+			}
+
+		private:
+			std::shared_ptr<Channel<T, Capacity>> channel;
+	};
+
+	/** \brief Consumer end of the stream, like std::future for many
+	 *         values */
+	template<typename T, std::size_t Capacity>
+	class Receiver
+	{
+		public:
+			explicit Receiver(std::shared_ptr<Channel<T, Capacity>> c)
+				: channel(std::move(c)) {}
+
+			/** \brief Waits for the next value, nullopt when the stream
+			 *         is closed and empty */
+			std::optional<T> next()
+			{
+				unsigned spins{ 0 };
+				while (true)
+				{
+					if (auto v{ channel->ring.try_pop() }) { return v; }
+					if (channel->closed.load(std::memory_order_acquire))
+					{
+						// Values pushed before close are visible now
+						return channel->ring.try_pop();
+					}
+					backoff(spins);
+				}
+			}
+
+		private:
+			std::shared_ptr<Channel<T, Capacity>> channel;
+	};
+
+	template<typename T, std::size_t Capacity = 1024>
+	std::pair<Sender<T, Capacity>, Receiver<T, Capacity>> make()
+	{
+		auto c{ std::make_shared<Channel<T, Capacity>>() };
+		return { Sender<T, Capacity>(c), Receiver<T, Capacity>(c) };
+	}
+}
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Single producer single consumer ring demo" << std::endl;
+
+	{
+	std::cout << "streaming values between threads: ";
+	auto [sender, receiver]{ stream::make<std::string, 4>() };
+	auto t{ std::thread{ [s = std::move(sender)]() mutable {
+		for (auto v : { "foo", "bar", "baz", "qux", "quux" }) { s.push(v); }
+		// Sender closes the stream when it's destroyed
+	} } };
+	while (auto v{ receiver.next() }) { std::cout << *v << " "; }
+	std::cout << std::endl;
+	t.join();
+
+	std::cout << "batch push and pop: ";
+	auto ring{ SpscRing<int, 8>{} };
+	auto in{ std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 } };
+	std::cout << ring.push_batch(in.begin(), in.end()) << " pushed, ";
+	auto out{ std::vector<int>(10) };
+	std::cout << ring.pop_batch(out.begin(), out.size()) << " popped"
+		<< std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	std::cout << std::endl << "Benchmark, " << n << " messages" << std::endl;
+
+	auto rate{ [&](double ms) { return n / ms * 1000; } };
+	auto ring{ std::make_unique<SpscRing<long, 1024>>() };
+
+	auto sum{ 0l };
+	auto ring_ms{ measure([&]() {
+		auto producer{ std::thread{ [&]() {
+			unsigned spins{ 0 };
+			for (long i{ 0 }; i < n; i++)
+			{
+				while (!ring->try_push(i)) { stream::backoff(spins); }
+			}
+		} } };
+		unsigned spins{ 0 };
+		for (long i{ 0 }; i < n; )
+		{
+			if (auto v{ ring->try_pop() }) { sum += *v; i++; }
+			else { stream::backoff(spins); }
+		}
+		producer.join(); }) };
+
+	auto batch_sum{ 0l };
+	auto batch_ms{ measure([&]() {
+		auto producer{ std::thread{ [&]() {
+			unsigned spins{ 0 };
+			auto batch{ std::vector<long>(64) };
+			for (long i{ 0 }; i < n; )
+			{
+				auto size{ std::min<long>(64, n - i) };
+				for (long j{ 0 }; j < size; j++) { batch[j] = i + j; }
+				auto first{ batch.begin() };
+				auto last{ batch.begin() + size };
+				while (first != last)
+				{
+					auto pushed{ ring->push_batch(first, last) };
+					if (pushed == 0) { stream::backoff(spins); }
+					first += pushed;
+				}
+				i += size;
+			}
+		} } };
+		unsigned spins{ 0 };
+		auto batch{ std::vector<long>(64) };
+		for (long i{ 0 }; i < n; )
+		{
+			auto popped{ ring->pop_batch(batch.begin(), batch.size()) };
+			if (popped == 0) { stream::backoff(spins); }
+			for (std::size_t j{ 0 }; j < popped; j++)
+			{
+				batch_sum += batch[j];
+			}
+			i += popped;
+		}
+		producer.join(); }) };
+
+	auto future_sum{ 0l };
+	auto future_ms{ measure([&]() {
+		auto promises{ std::vector<std::promise<long>>(n) };
+		auto futures{ std::vector<std::future<long>>{} };
+		futures.reserve(n);
+		for (auto& p : promises) { futures.push_back(p.get_future()); }
+		auto producer{ std::thread{ [&]() {
+			for (long i{ 0 }; i < n; i++) { promises[i].set_value(i); }
+		} } };
+		for (auto& f : futures) { future_sum += f.get(); }
+		producer.join(); }) };
+
+	std::cout << "messages/s:"
+		<< " SpscRing: " << rate(ring_ms)
+		<< " SpscRing batches: " << rate(batch_ms)
+		<< " std::promise per value: " << rate(future_ms) << std::endl;
+	std::cout << (sum == batch_sum && sum == future_sum
+		? "sums match" : "SUMS DIFFER") << std::endl;
+
+	// Latency: the message goes to the other thread and back
+	auto rounds{ std::max(1l, n / 100) };
+	auto ping{ std::make_unique<SpscRing<long, 2>>() };
+	auto pong{ std::make_unique<SpscRing<long, 2>>() };
+	auto ring_rt{ measure([&]() {
+		auto echo{ std::thread{ [&]() {
+			unsigned spins{ 0 };
+			for (long i{ 0 }; i < rounds; )
+			{
+				if (auto v{ ping->try_pop() }) { pong->try_push(*v); i++; }
+				else { stream::backoff(spins); }
+			}
+		} } };
+		unsigned spins{ 0 };
+		for (long i{ 0 }; i < rounds; i++)
+		{
+			ping->try_push(i);
+			while (!pong->try_pop()) { stream::backoff(spins); }
+		}
+		echo.join(); }) };
+
+	auto future_rt{ measure([&]() {
+		// A new shared state for every message in both directions
+		auto requests{ std::vector<std::promise<long>>(rounds) };
+		auto replies{ std::vector<std::promise<long>>(rounds) };
+		auto echo{ std::thread{ [&]() {
+			for (long i{ 0 }; i < rounds; i++)
+			{
+				replies[i].set_value(requests[i].get_future().get());
+			}
+		} } };
+		for (long i{ 0 }; i < rounds; i++)
+		{
+			auto answer{ replies[i].get_future() };
+			requests[i].set_value(i);
+			answer.get();
+		}
+		echo.join(); }) };
+
+	auto us{ [&](double ms) { return ms * 1000 / rounds; } };
+	std::cout << "round trip, us:"
+		<< " SpscRing: " << us(ring_rt)
+		<< " std::promise per value: " << us(future_rt) << std::endl;
+	}
+
+	return 0;
+}
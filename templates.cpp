@@ -1,14 +1,17 @@
 #include <iostream>
+#include <map>
+#include "type_name.h"
 
 // Debugging helper. debug_type function intensionally produces an error that
-// contains the real type of the variable.
+// contains the real type of the variable. type_name<T>() from type_name.h
+// gives the same name without breaking the build.
 template<typename T> struct TypePrinter;
 template<typename T> void debug_type() { TypePrinter<T> x; }
 
 template<typename T> // Declaring T as name of the type
 T identity(T value)
 {
-	std::cout << "T is: " << typeid(T).name() << std::endl;
+	std::cout << "T is: " << type_name<T>() << std::endl;
 	return value;
 }
 
@@ -43,8 +46,8 @@ int main(int argc, char** argv)
 	std::cout << "Basic type deduction debugging technique:" << std::endl;
 	int i;
 	auto j{ 3.14 };
-	std::cout << "i has type: " << typeid(i).name() << std::endl;
-	std::cout << "j has type: " << typeid(decltype(j)).name() << std::endl;
+	std::cout << "i has type: " << type_name<decltype(i)>() << std::endl;
+	std::cout << "j has type: " << type_name<decltype(j)>() << std::endl;
 	}
 
 	{
@@ -57,16 +60,31 @@ int main(int argc, char** argv)
 
 	const auto& ri{ i }; identity(ri); // debug_type(ri);
 	std::cout << "ri has type: "
-		<< typeid(decltype((ri))).name()
+		<< type_name<decltype((ri))>()
 		<< std::endl;
 	
 	const auto&& uri{ std::move(i) };
 	std::cout << "uri has type: "
-		<< typeid(decltype(uri)).name()
+		<< type_name<decltype(uri)>()
 		<< std::endl;
 
 	}
 
+	{
+	std::cout << "Compile-time type names and ids" << std::endl;
+	// Names are constant expressions, ids are addresses, no RTTI is used
+	static_assert(type_name<int>() == "int");
+	std::cout << "int and const int have "
+		<< (type_id<int>() != type_id<const int>() ? "different" : "same")
+		<< " ids" << std::endl;
+
+	auto names{ std::map<TypeId, std::string_view>{
+		{ type_id<int>(), type_name<int>() },
+		{ type_id<double>(), type_name<double>() } } };
+	std::cout << "type_id<double> is a key of: "
+		<< names[type_id<double>()] << std::endl;
+	}
+
 	{
 	std::cout << "Variadic parameters template example" << std::endl;
 	print_all("This line ", "is made from ", 4, " parameters!");
@@ -0,0 +1,547 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <array>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <string>
+#include <limits>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <system_error>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// A sleeping thread per timeout doesn't scale, and a heap of deadlines costs
+// O(log n) for every insert and needs a search or a tombstone to cancel. The
+// timing wheel is an array of lists indexed by the deadline: insert and
+// cancel are O(1) list operations. One wheel of 64 slots covers 64 ticks, so
+// the wheels are stacked: every level covers 64 times the span of the
+// previous one, and when the lower level goes round, the next slot of the
+// upper level is redistributed into it.
+
+/** \brief Timer handle, stays invalid after the timer fires or is cancelled */
+struct TimerId
+{
+	std::uint32_t index{ std::numeric_limits<std::uint32_t>::max() };
+	std::uint32_t generation{ 0 };
+};
+
+/** \brief   Hierarchical timing wheel counting abstract ticks
+ *  \details 4 levels of 64 slots cover 2^24 ticks, later deadlines wait on
+ *           the top level and are redistributed until they are in range.
+ *           Timers live in one vector linked by indexes, freed timers are
+ *           reused, so there are no allocations in the steady state. Not
+ *           thread-safe. */
+template<typename Callback = std::function<void()>>
+class TimingWheel
+{
+	static constexpr unsigned Bits{ 6 };
+	static constexpr unsigned Levels{ 4 };
+	static constexpr std::uint32_t SlotCount{ 1u << Bits };
+	static constexpr std::uint32_t Mask{ SlotCount - 1 };
+	static constexpr std::uint64_t Span{ 1ull << (Bits * Levels) };
+	static constexpr std::uint32_t Nil{
+		std::numeric_limits<std::uint32_t>::max() };
+
+	public:
+		/** \brief Current tick */
+		std::uint64_t now() const { return current; }
+
+		std::size_t size() const { return count; }
+
+		bool empty() const { return count == 0; }
+
+		/** \brief Calls the callback when the wheel reaches the tick, at the
+		 *         next tick if it has passed already */
+		TimerId schedule_at(std::uint64_t tick, Callback callback)
+		{
+			auto index{ allocate() };
+			auto& timer{ timers[index] };
+			timer.deadline = std::max(tick, current + 1);
+			timer.callback = std::move(callback);
+			link(index);
+			count++;
+			return { index, timer.generation };
+		}
+
+		TimerId schedule_after(std::uint64_t ticks, Callback callback)
+		{
+			return schedule_at(current + ticks, std::move(callback));
+		}
+
+		/** \brief Removes the timer, false if it has fired or is cancelled
+		 *         already */
+		bool cancel(TimerId id)
+		{
+			if (id.index >= timers.size()
+				|| timers[id.index].generation != id.generation
+				|| timers[id.index].slot == Nil)
+			{
+				return false;
+			}
+			unlink(id.index);
+			release(id.index);
+			count--;
+			return true;
+		}
+
+		/** \brief   Moves the wheel forward by the ticks and passes the
+		 *           callbacks of the expired timers to sink(Callback&&)
+		 *  \details The sink is called in the order of the deadlines. An
+		 *           empty wheel jumps at once. */
+		template<typename Sink>
+		void advance(std::uint64_t ticks, Sink&& sink)
+		{
+			for (; ticks > 0; ticks--)
+			{
+				if (count == 0)
+				{
+					current += ticks;
+					return;
+				}
+				current++;
+				auto index{ std::uint32_t(current & Mask) };
+				// The lower level went round: redistribute the next slot
+				// of the upper one, and further up while they go round too
+				for (unsigned level{ 1 }; index == 0 && level < Levels;
+					level++)
+				{
+					index = (current >> (level * Bits)) & Mask;
+					cascade(level * SlotCount + index);
+				}
+				expire(current & Mask, sink);
+			}
+		}
+
+	private:
+		struct Timer
+		{
+			std::uint64_t deadline;
+			std::uint32_t prev;
+			std::uint32_t next;
+			std::uint32_t slot{ Nil };  // Nil when not scheduled
+			std::uint32_t generation{ 0 };
+			Callback callback;
+		};
+
+		std::uint32_t allocate()
+		{
+			if (free_list != Nil)
+			{
+				auto index{ free_list };
+				free_list = timers[index].next;
+				return index;
+			}
+			timers.emplace_back();
+			return timers.size() - 1;
+		}
+
+		void release(std::uint32_t index)
+		{
+			auto& timer{ timers[index] };
+			timer.callback = Callback{};
+			timer.slot = Nil;
+			timer.generation++;
+			timer.next = free_list;
+			free_list = index;
+		}
+
+		// The level is chosen by the distance to the deadline, the slot by
+		// the deadline's digit of that level
+		std::uint32_t slot_of(std::uint64_t deadline) const
+		{
+			auto distance{ std::min(deadline - current, Span - 1) };
+			auto target{ current + distance };
+			for (unsigned level{ 0 }; level < Levels; level++)
+			{
+				if (distance < (std::uint64_t(1) << (Bits * (level + 1))))
+				{
+					return level * SlotCount
+						+ ((target >> (level * Bits)) & Mask);
+				}
+			}
+			return 0;
+		}
+
+		void link(std::uint32_t index)
+		{
+			auto& timer{ timers[index] };
+			timer.slot = slot_of(timer.deadline);
+			timer.prev = Nil;
+			timer.next = slots[timer.slot];
+			if (timer.next != Nil) { timers[timer.next].prev = index; }
+			slots[timer.slot] = index;
+		}
+
+		void unlink(std::uint32_t index)
+		{
+			auto& timer{ timers[index] };
+			if (timer.prev != Nil) { timers[timer.prev].next = timer.next; }
+			else { slots[timer.slot] = timer.next; }
+			if (timer.next != Nil) { timers[timer.next].prev = timer.prev; }
+		}
+
+		void cascade(std::uint32_t slot)
+		{
+			auto index{ std::exchange(slots[slot], Nil) };
+			while (index != Nil)
+			{
+				auto next{ timers[index].next };
+				link(index);
+				index = next;
+			}
+		}
+
+		template<typename Sink>
+		void expire(std::uint32_t slot, Sink& sink)
+		{
+			// Linked at the head, so the list is reversed: collect first
+			// to fire the timers in the order they were scheduled
+			expired.clear();
+			auto index{ std::exchange(slots[slot], Nil) };
+			for (; index != Nil; index = timers[index].next)
+			{
+				expired.push_back(index);
+			}
+			for (auto i{ expired.size() }; i-- > 0;)
+			{
+				auto callback{ std::move(timers[expired[i]].callback) };
+				release(expired[i]);
+				count--;
+				sink(std::move(callback));
+			}
+		}
+
+		std::vector<Timer> timers;
+		std::array<std::uint32_t, SlotCount * Levels> slots{ filled() };
+		std::vector<std::uint32_t> expired;
+		std::uint32_t free_list{ Nil };
+		std::uint64_t current{ 0 };
+		std::size_t count{ 0 };
+
+		static constexpr auto filled()
+		{
+			auto s{ std::array<std::uint32_t, SlotCount * Levels>{} };
+			s.fill(Nil);
+			return s;
+		}
+};
+
+/** \brief Small pool that runs the timer callbacks */
+class WorkerPool
+{
+	public:
+		explicit WorkerPool(unsigned workers)
+		{
+			for (unsigned i{ 0 }; i < workers; i++)
+			{
+				threads.push_back(std::thread{ [this]() { work(); } });
+			}
+		}
+
+		~WorkerPool()
+		{
+			{
+				auto lock{ std::lock_guard(m) };
+				stop = true;
+			}
+			cv.notify_all();
+			for (auto& t : threads) { t.join(); }
+		}
+
+		void post(std::function<void()> f)
+		{
+			{
+				auto lock{ std::lock_guard(m) };
+				tasks.push_back(std::move(f));
+			}
+			cv.notify_one();
+		}
+
+	private:
+		void work()
+		{
+			while (true)
+			{
+				auto lock{ std::unique_lock(m) };
+				cv.wait(lock, [&]() { return stop || !tasks.empty(); });
+				if (tasks.empty()) { return; }
+				auto f{ std::move(tasks.front()) };
+				tasks.pop_front();
+				lock.unlock();
+				f();
+			}
+		}
+
+		std::mutex m;
+		std::condition_variable cv;
+		std::deque<std::function<void()>> tasks;
+		bool stop{ false };
+		std::vector<std::thread> threads;
+};
+
+/** \brief   Timing wheel driven by a thread that waits on a timerfd
+ *  \details The timerfd ticks only while there are timers. The ticks are
+ *           counted from the steady clock, so late wake-ups catch up rather
+ *           than drift. The callbacks are posted to the pool outside of the
+ *           lock, so they may schedule and cancel timers. */
+class TimerService
+{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		TimerService(WorkerPool& pool,
+			Clock::duration tick = std::chrono::milliseconds(1))
+			: pool(pool), tick(tick), start(Clock::now())
+		{
+			timer_fd = check(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC));
+			event_fd = check(eventfd(0, EFD_CLOEXEC));
+			epoll_fd = check(epoll_create1(EPOLL_CLOEXEC));
+			for (auto fd : { timer_fd, event_fd })
+			{
+				auto event{ epoll_event{} };
+				event.events = EPOLLIN;
+				event.data.fd = fd;
+				check(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event));
+			}
+			thread = std::thread{ [this]() { loop(); } };
+		}
+
+		~TimerService()
+		{
+			std::uint64_t one{ 1 };
+			[[maybe_unused]] auto _{ write(event_fd, &one, sizeof(one)) };
+			thread.join();
+			for (auto fd : { timer_fd, event_fd, epoll_fd }) { close(fd); }
+		}
+
+		TimerId schedule(Clock::duration delay, std::function<void()> f)
+		{
+			auto lock{ std::lock_guard(m) };
+			if (wheel.empty())
+			{
+				// The wheel stands still without timers: move it to now
+				wheel.advance(ticks_now() - wheel.now(), [](auto&&) {});
+				arm(true);
+			}
+			// Rounded up, the timer never fires early
+			auto ticks{ (delay + tick - Clock::duration(1)) / tick };
+			return wheel.schedule_at(ticks_now() + std::max<long>(ticks, 1),
+				std::move(f));
+		}
+
+		bool cancel(TimerId id)
+		{
+			auto lock{ std::lock_guard(m) };
+			return wheel.cancel(id);
+		}
+
+	private:
+		static int check(int result)
+		{
+			if (result < 0)
+			{
+				throw std::system_error(errno, std::generic_category());
+			}
+			return result;
+		}
+
+		std::uint64_t ticks_now() const
+		{
+			return (Clock::now() - start) / tick;
+		}
+
+		void arm(bool on)
+		{
+			auto spec{ itimerspec{} };
+			if (on)
+			{
+				auto ns{ std::chrono::nanoseconds(tick).count() };
+				spec.it_interval = { ns / 1'000'000'000, ns % 1'000'000'000 };
+				spec.it_value = spec.it_interval;
+			}
+			timerfd_settime(timer_fd, 0, &spec, nullptr);
+		}
+
+		void loop()
+		{
+			auto expired{ std::vector<std::function<void()>>{} };
+			while (true)
+			{
+				auto event{ epoll_event{} };
+				if (epoll_wait(epoll_fd, &event, 1, -1) <= 0) { continue; }
+				if (event.data.fd == event_fd) { return; }
+
+				std::uint64_t expirations;
+				if (read(timer_fd, &expirations, sizeof(expirations)) < 0)
+				{
+					continue;
+				}
+				{
+					auto lock{ std::lock_guard(m) };
+					auto now{ ticks_now() };
+					if (now > wheel.now())
+					{
+						wheel.advance(now - wheel.now(), [&](auto&& f) {
+							expired.push_back(std::move(f)); });
+					}
+					if (wheel.empty()) { arm(false); }
+				}
+				for (auto& f : expired) { pool.post(std::move(f)); }
+				expired.clear();
+			}
+		}
+
+		WorkerPool& pool;
+		Clock::duration tick;
+		Clock::time_point start;
+		std::mutex m;
+		TimingWheel<> wheel;
+		int timer_fd;
+		int event_fd;
+		int epoll_fd;
+		std::thread thread;
+};
+
+template<typename F>
+double measure(F&& f)
+{
+	auto start{ std::chrono::steady_clock::now() };
+	f();
+	auto end{ std::chrono::steady_clock::now() };
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	std::cout << "Timing wheel demo" << std::endl;
+
+	{
+	auto wheel{ TimingWheel<std::string>{} };
+	wheel.schedule_after(5, "five");
+	auto id{ wheel.schedule_after(3, "three, cancelled") };
+	wheel.schedule_after(100'000, "hundred thousand");
+	wheel.schedule_after(1, "one");
+	std::cout << "cancelled: " << std::boolalpha << wheel.cancel(id)
+		<< ", again: " << wheel.cancel(id) << std::endl;
+	wheel.advance(200'000, [&](std::string&& s) {
+		std::cout << "tick " << wheel.now() << ": " << s << std::endl; });
+	}
+
+	{
+	std::cout << "timer service, 1 ms ticks:" << std::endl;
+	// The callbacks use these, so they are destroyed after the pool
+	auto m{ std::mutex{} };
+	auto fired{ std::atomic<int>{ 0 } };
+	auto start{ std::chrono::steady_clock::now() };
+	auto report{ [&](const char* name) {
+		auto ms{ std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count() };
+		auto lock{ std::lock_guard(m) };
+		std::cout << "  " << name << " after " << int(ms) << " ms"
+			<< std::endl; } };
+
+	auto pool{ WorkerPool(2) };
+	auto timers{ TimerService(pool) };
+
+	using namespace std::chrono_literals;
+	timers.schedule(30ms, [&]() { report("30 ms"); });
+	timers.schedule(10ms, [&]() { report("10 ms"); });
+	auto id{ timers.schedule(20ms, [&]() { report("20 ms, cancelled"); }) };
+	timers.cancel(id);
+
+	// Many short timeouts, every fourth is cancelled like the timeout of a
+	// request that was answered in time. The early ones may fire before
+	// the cancel comes.
+	auto ids{ std::vector<TimerId>{} };
+	for (int i{ 0 }; i < 100'000; i++)
+	{
+		ids.push_back(timers.schedule(std::chrono::milliseconds(1 + i % 40),
+			[&]() { fired++; }));
+	}
+	auto cancelled{ 0 };
+	for (std::size_t i{ 0 }; i < ids.size(); i += 4)
+	{
+		cancelled += timers.cancel(ids[i]);
+	}
+	std::this_thread::sleep_for(100ms);
+	auto lock{ std::lock_guard(m) };
+	std::cout << "  " << fired << " of " << 100'000 - cancelled
+		<< " timeouts fired" << std::endl;
+	}
+
+	{
+	auto n{ argc > 1 ? std::stol(argv[1]) : 1'000'000l };
+	std::cout << std::endl << "Benchmark, " << n
+		<< " timers over 100000 ticks, half cancelled, million ops/s"
+		<< std::endl;
+
+	auto generator{ std::mt19937_64{ 42 } };
+	auto delays{ std::vector<std::uint64_t>(n) };
+	for (auto& d : delays) { d = 1 + generator() % 100'000; }
+	auto rate{ [](long ops, double ms) { return ops / ms / 1000; } };
+
+	// Callbacks are indexes, so both sides measure the bookkeeping only
+	auto wheel_fired{ 0l };
+	auto wheel_sum{ 0ul };
+	auto wheel{ TimingWheel<long>{} };
+	auto ids{ std::vector<TimerId>(n) };
+	auto wheel_insert{ measure([&]() {
+		for (long i{ 0 }; i < n; i++)
+		{
+			ids[i] = wheel.schedule_after(delays[i], i);
+		} }) };
+	auto wheel_cancel{ measure([&]() {
+		for (long i{ 0 }; i < n; i += 2) { wheel.cancel(ids[i]); } }) };
+	auto wheel_fire{ measure([&]() {
+		wheel.advance(100'000, [&](long i) {
+			wheel_fired++;
+			wheel_sum += i; }); }) };
+
+	// The heap can't remove from the middle: cancelled timers are marked
+	// and skipped when they come to the top
+	using Entry = std::pair<std::uint64_t, long>;
+	auto heap{ std::priority_queue<Entry, std::vector<Entry>,
+		std::greater<Entry>>{} };
+	auto cancelled{ std::vector<bool>(n) };
+	auto heap_fired{ 0l };
+	auto heap_sum{ 0ul };
+	auto heap_insert{ measure([&]() {
+		for (long i{ 0 }; i < n; i++) { heap.push({ delays[i], i }); } }) };
+	auto heap_cancel{ measure([&]() {
+		for (long i{ 0 }; i < n; i += 2) { cancelled[i] = true; } }) };
+	auto heap_fire{ measure([&]() {
+		for (std::uint64_t now{ 1 }; now <= 100'000; now++)
+		{
+			while (!heap.empty() && heap.top().first <= now)
+			{
+				auto i{ heap.top().second };
+				heap.pop();
+				if (cancelled[i]) { continue; }
+				heap_fired++;
+				heap_sum += i;
+			}
+		} }) };
+
+	std::cout << "insert: TimingWheel: " << rate(n, wheel_insert)
+		<< " priority_queue: " << rate(n, heap_insert) << std::endl;
+	std::cout << "cancel: TimingWheel: " << rate(n / 2, wheel_cancel)
+		<< " priority_queue: " << rate(n / 2, heap_cancel) << std::endl;
+	std::cout << "fire: TimingWheel: " << rate(wheel_fired, wheel_fire)
+		<< " priority_queue: " << rate(heap_fired, heap_fire) << std::endl;
+	std::cout << (wheel_fired == heap_fired && wheel_sum == heap_sum
+		? "results match" : "RESULTS DIFFER") << std::endl;
+	}
+
+	return 0;
+}
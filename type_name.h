@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string_view>
+
+// Type names and ids without RTTI. The compiler puts the template arguments
+// into __PRETTY_FUNCTION__, so the name of T is a part of a string literal
+// known at compile time:
+// GCC:   "... type_name() [with T = int; std::string_view = ...]"
+// Clang: "... type_name() [T = int]"
+// Unlike typeid(T).name() the name is not mangled, keeps the references
+// and cv-qualifiers, and the binary may be built with -fno-rtti.
+
+/** \brief   Readable name of the type, usable in constant expressions
+ *  \details The name is for printing, it doesn't identify the type: see
+ *           type_id() for the cases where different types share a name. */
+template<typename T>
+constexpr std::string_view type_name()
+{
+	constexpr std::string_view pretty{ __PRETTY_FUNCTION__ };
+	constexpr auto begin{ pretty.find("T = ") + 4 };
+	constexpr auto semicolon{ pretty.find(';', begin) };
+	constexpr auto end{ semicolon == std::string_view::npos
+		? pretty.rfind(']') : semicolon };
+	return pretty.substr(begin, end - begin);
+}
+
+/** \brief   Unique address per type, used instead of typeid
+ *  \details Every instantiation of the variable template is a separate
+ *           object, so its address identifies the type. */
+template<typename T>
+inline constexpr char type_tag{};
+
+using TypeId = const void*;
+
+/** \brief   Id of the type, the address of its type_tag
+ *  \details Works as a map key, and the comparison is just the pointer
+ *           comparison. It's constexpr, but the addresses of different
+ *           objects compare only at run time with some compilers (GCC
+ *           with -fsanitize=undefined), so don't rely on it in
+ *           static_assert. Unlike type_name() it is unique:
+ *           names may collide, e.g. two lambdas in one function are both
+ *           "main()::<lambda()>", and the types from unnamed namespaces of
+ *           different translation units are all "{anonymous}::X". The
+ *           address is not stable between runs, so ids must not be saved. */
+template<typename T>
+constexpr TypeId type_id() { return &type_tag<T>; }